@@ -4,26 +4,386 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+
+#define HTML_CONTEXT_ARENA 0x1
+#define HTML_CONTEXT_STREAMING 0x2
+#define HTML_CONTEXT_RENDER_CACHE 0x4
+#define HTML_CONTEXT_GZIP 0x8
+
+#define HTML_ARENA_DEFAULT_BLOCK_SIZE (64 * 1024)
+
+#define HTML_WRITER_BLOCK_SIZE (64 * 1024)
+#define HTML_WRITER_MAX_INDENT 64
+
+#define HTML_SINK_ASYNC_BUFFER_SIZE (1024 * 1024)
+
+#define HTML_POOL_DEFAULT_SIZE 64
+
+#define HTML_GZIP_FAST 1
+#define HTML_GZIP_DEFAULT_LEVEL 6
+#define HTML_GZIP_BEST 9
+
+#define HTML_RENDER_MINIFIED 0x1
+#define HTML_RENDER_CRLF 0x2
+#define HTML_RENDER_ESCAPE 0x4
+
+// "%.*f" of the largest double: sign, 309 digits, point, fraction, NUL
+#define HTML_NUMBER_MAX_PRECISION 40
+#define HTML_NUMBER_BUFFER_SIZE (1 + 309 + 1 + HTML_NUMBER_MAX_PRECISION + 1)
+
+#define HTML_RENDER_DEFAULT_INDENT_WIDTH 2
+#define HTML_RENDER_DEFAULT_INDENT_LIMIT 40
+
+#define HTML_ELEMENT_OWNS_SELF 0x1
+#define HTML_ELEMENT_OWNS_CONTENT 0x2
+#define HTML_ELEMENT_OWNS_ATTRIBUTES 0x4
+#define HTML_ELEMENT_OWNS_ATTRIBUTE_DATA 0x8
+#define HTML_ELEMENT_OWNS_CHILDREN 0x10
+
+#define HTML_ELEMENT_ID_INDEXED 0x100
+#define HTML_ELEMENT_INDEXED 0x200
+#define HTML_ELEMENT_STREAM_OPEN 0x400
+#define HTML_ELEMENT_DIRTY 0x800
+#define HTML_ELEMENT_CACHED 0x1000
+#define HTML_ELEMENT_ESCAPE 0x2000
+
+#define HTML_ATTRIBUTE_OWNS_VALUE 0x1
+
+typedef enum html_error_code
+{
+    HTML_ERROR_NONE = 0,
+    HTML_ERROR_FAILED,
+    HTML_ERROR_MEMORY,
+    HTML_ERROR_INVALID_ARGUMENT,
+    HTML_ERROR_INVALID_STATE,
+    HTML_ERROR_INVALID_CHILD,
+    HTML_ERROR_DUPLICATE_ID,
+    HTML_ERROR_NOT_FOUND,
+    HTML_ERROR_IO,
+    HTML_ERROR_UNSUPPORTED
+} html_error_code;
+
+typedef enum html_tag
+{
+    HTML_TAG_UNKNOWN = 0,
+    HTML_TAG_A,
+    HTML_TAG_ABBR,
+    HTML_TAG_ADDRESS,
+    HTML_TAG_AREA,
+    HTML_TAG_ARTICLE,
+    HTML_TAG_ASIDE,
+    HTML_TAG_AUDIO,
+    HTML_TAG_B,
+    HTML_TAG_BASE,
+    HTML_TAG_BDI,
+    HTML_TAG_BDO,
+    HTML_TAG_BLOCKQUOTE,
+    HTML_TAG_BODY,
+    HTML_TAG_BR,
+    HTML_TAG_BUTTON,
+    HTML_TAG_CANVAS,
+    HTML_TAG_CAPTION,
+    HTML_TAG_CITE,
+    HTML_TAG_CODE,
+    HTML_TAG_COL,
+    HTML_TAG_COLGROUP,
+    HTML_TAG_DATA,
+    HTML_TAG_DATALIST,
+    HTML_TAG_DD,
+    HTML_TAG_DEL,
+    HTML_TAG_DETAILS,
+    HTML_TAG_DFN,
+    HTML_TAG_DIALOG,
+    HTML_TAG_DIV,
+    HTML_TAG_DL,
+    HTML_TAG_DT,
+    HTML_TAG_EM,
+    HTML_TAG_EMBED,
+    HTML_TAG_FIELDSET,
+    HTML_TAG_FIGCAPTION,
+    HTML_TAG_FIGURE,
+    HTML_TAG_FOOTER,
+    HTML_TAG_FORM,
+    HTML_TAG_H1,
+    HTML_TAG_H2,
+    HTML_TAG_H3,
+    HTML_TAG_H4,
+    HTML_TAG_H5,
+    HTML_TAG_H6,
+    HTML_TAG_HEAD,
+    HTML_TAG_HEADER,
+    HTML_TAG_HR,
+    HTML_TAG_HTML,
+    HTML_TAG_I,
+    HTML_TAG_IFRAME,
+    HTML_TAG_IMG,
+    HTML_TAG_INPUT,
+    HTML_TAG_INS,
+    HTML_TAG_KBD,
+    HTML_TAG_LABEL,
+    HTML_TAG_LEGEND,
+    HTML_TAG_LI,
+    HTML_TAG_LINK,
+    HTML_TAG_MAIN,
+    HTML_TAG_MAP,
+    HTML_TAG_MARK,
+    HTML_TAG_META,
+    HTML_TAG_METER,
+    HTML_TAG_NAV,
+    HTML_TAG_NOSCRIPT,
+    HTML_TAG_OBJECT,
+    HTML_TAG_OL,
+    HTML_TAG_OPTGROUP,
+    HTML_TAG_OPTION,
+    HTML_TAG_OUTPUT,
+    HTML_TAG_P,
+    HTML_TAG_PARAM,
+    HTML_TAG_PICTURE,
+    HTML_TAG_PRE,
+    HTML_TAG_PROGRESS,
+    HTML_TAG_Q,
+    HTML_TAG_RP,
+    HTML_TAG_RT,
+    HTML_TAG_RUBY,
+    HTML_TAG_S,
+    HTML_TAG_SAMP,
+    HTML_TAG_SCRIPT,
+    HTML_TAG_SECTION,
+    HTML_TAG_SELECT,
+    HTML_TAG_SLOT,
+    HTML_TAG_SMALL,
+    HTML_TAG_SOURCE,
+    HTML_TAG_SPAN,
+    HTML_TAG_STRONG,
+    HTML_TAG_STYLE,
+    HTML_TAG_SUB,
+    HTML_TAG_SUMMARY,
+    HTML_TAG_SUP,
+    HTML_TAG_TABLE,
+    HTML_TAG_TBODY,
+    HTML_TAG_TD,
+    HTML_TAG_TEMPLATE,
+    HTML_TAG_TEXTAREA,
+    HTML_TAG_TFOOT,
+    HTML_TAG_TH,
+    HTML_TAG_THEAD,
+    HTML_TAG_TIME,
+    HTML_TAG_TITLE,
+    HTML_TAG_TR,
+    HTML_TAG_TRACK,
+    HTML_TAG_U,
+    HTML_TAG_UL,
+    HTML_TAG_VAR,
+    HTML_TAG_VIDEO,
+    HTML_TAG_WBR,
+    HTML_TAG_KNOWN_COUNT
+} html_tag;
+
+typedef struct html_name_table
+{
+    char **names;
+    int count;
+    int capacity;
+    int *slots;
+    int slot_capacity;
+} html_name_table;
+
+typedef struct html_arena_block
+{
+    struct html_arena_block *next;
+    char *data;
+    size_t size;
+    size_t used;
+} html_arena_block;
+
+typedef struct html_arena
+{
+    html_arena_block *head;
+    html_arena_block *spare;
+    size_t block_size;
+    void *last;
+} html_arena;
+
+struct html_context;
+
+typedef struct html_attribute
+{
+    const char *name;
+    char *value;
+    unsigned int length;
+    unsigned int capacity;
+    unsigned char quote;
+    unsigned char flags;
+} html_attribute;
 
 typedef struct html_element
 {
     char *id;
-    char *tagname;
+    const char *tagname;
+    int tag;
     char *content;
     struct html_element *parent;
     struct html_element **children;
     int children_count;
     int children_capacity;
-    char *attributes;
+    html_attribute *attributes;
+    int attribute_count;
+    int attribute_capacity;
+    void *attribute_data;
+    struct html_context *owner;
+    unsigned int flags;
+    int index_slot;
+    size_t cache_offset;
+    size_t cache_length;
 } html_element;
 
-typedef struct
+typedef struct html_table
 {
-    char **keys;
-    html_element **values;
+    unsigned char *ctrl;
+    const char **keys;
+    void **values;
     int capacity;
     int size;
-} id_map;
+    int tombstones;
+} html_table;
+
+typedef html_table id_map;
+
+typedef struct html_selector html_selector;
+
+typedef struct html_element_list
+{
+    html_element **items;
+    int count;
+    int capacity;
+    int removed;
+} html_element_list;
+
+typedef int (*html_writer_flush_fn)(void *target, const char *data, size_t len);
+
+typedef struct html_writer
+{
+    char *data;
+    size_t length;
+    size_t capacity;
+    html_writer_flush_fn flush;
+    void *target;
+    int error;
+    void *vectors;
+    int vector_count;
+    size_t segment;
+} html_writer;
+
+typedef struct html_sink_ops
+{
+    int (*write)(void *state, const char *data, size_t len);
+    int (*flush)(void *state);
+    void (*close)(void *state);
+} html_sink_ops;
+
+typedef struct html_sink
+{
+    const html_sink_ops *ops;
+    void *state;
+} html_sink;
+
+typedef struct html_gzip_sink
+{
+    void *stream;
+    char *buffer;
+    size_t capacity;
+    html_writer_flush_fn flush;
+    void *target;
+    int level;
+    int started;
+    int error;
+} html_gzip_sink;
+
+typedef struct html_render_cursor html_render_cursor;
+
+typedef struct html_template html_template;
+
+typedef struct html_fragment html_fragment;
+
+typedef struct html_context_pool html_context_pool;
+
+typedef struct html_fragment_override
+{
+    const char *id;
+    const char *name;
+    const char *value;
+} html_fragment_override;
+
+typedef struct html_fragment_overrides
+{
+    const char *id_suffix;
+    const html_fragment_override *items;
+    int count;
+} html_fragment_overrides;
+
+typedef enum html_column_type
+{
+    HTML_COLUMN_TEXT = 0,
+    HTML_COLUMN_INT,
+    HTML_COLUMN_DOUBLE
+} html_column_type;
+
+// one table column; values points at nrows entries of const char *,
+// long long or double depending on type
+typedef struct html_table_column
+{
+    const char *header;
+    html_column_type type;
+    const void *values;
+    int precision;
+} html_table_column;
+
+typedef const char *(*html_table_cell_fn)(void *user, int row, int column);
+
+typedef struct html_render_options
+{
+    int flags;
+    int indent_width;
+    int indent_limit;
+} html_render_options;
+
+typedef struct html_render_cache
+{
+    char *data;
+    size_t length;
+    int level;
+    html_render_options options;
+} html_render_cache;
+
+typedef enum html_patch_type
+{
+    HTML_PATCH_SET_CONTENT,
+    HTML_PATCH_SET_ATTRIBUTE,
+    HTML_PATCH_REMOVE_ATTRIBUTE,
+    HTML_PATCH_INSERT_CHILD,
+    HTML_PATCH_REMOVE_CHILD,
+    HTML_PATCH_MOVE_CHILD,
+    HTML_PATCH_DETACH_CHILD
+} html_patch_type;
+
+typedef struct html_patch_op
+{
+    html_patch_type type;
+    int *path;
+    int path_length;
+    char *id;
+    char *name;
+    char *value;
+    int index;
+} html_patch_op;
+
+typedef struct html_patch
+{
+    html_patch_op *ops;
+    int count;
+    int capacity;
+} html_patch;
 
 typedef struct html_context
 {
@@ -31,12 +391,47 @@ typedef struct html_context
     html_element *current;
     id_map *element_map;
     FILE *output_file;
+    html_sink *sink;
     char *title;
     int indent_level;
+    int flags;
+    html_arena *arena;
+    html_arena *batch_arena;
+    html_writer *stream_writer;
+    html_gzip_sink *gzip;
+    FILE *gzip_file;
+    html_render_cache *render_cache;
+    html_table *class_index;
+    html_element_list *tag_index;
+    int tag_index_capacity;
+    unsigned int fragment_instances;
+    int rendered;
 } html_context;
 
 char *html_strdup(const char *str);
 
+char *html_escape_string(const char *str);
+
+html_arena *html_arena_create(size_t block_size);
+
+void *html_arena_alloc(html_arena *arena, size_t size);
+
+void *html_arena_realloc(html_arena *arena, void *ptr, size_t old_size, size_t new_size);
+
+char *html_arena_strdup(html_arena *arena, const char *str);
+
+void html_arena_reset(html_arena *arena);
+
+void html_arena_destroy(html_arena *arena);
+
+int html_element_in_arena(const html_element *element);
+
+void *html_element_alloc(html_element *element, size_t size, unsigned int field);
+
+void html_element_release(html_element *element, void *ptr, unsigned int field);
+
+char *html_element_strdup(html_element *element, const char *str, unsigned int field);
+
 char *html_add_attribute(const char *attributes, const char *name, const char *value);
 
 char *html_extract_attribute(const char *attributes, const char *name);
@@ -45,12 +440,74 @@ char *html_extract_id(const char *attributes);
 
 char *html_generate_indent(int level);
 
+int html_writer_init(html_writer *writer, size_t capacity, html_writer_flush_fn flush, void *target);
+
+int html_writer_init_file(html_writer *writer, FILE *file);
+
+int html_writer_init_fd(html_writer *writer, int fd);
+
+int html_writer_append(html_writer *writer, const char *data, size_t len);
+
+int html_writer_append_ref(html_writer *writer, const char *data, size_t len);
+
+int html_writer_puts(html_writer *writer, const char *str);
+
+int html_writer_putc(html_writer *writer, char c);
+
+int html_writer_indent(html_writer *writer, int spaces);
+
+int html_writer_flush(html_writer *writer);
+
+void html_writer_free(html_writer *writer);
+
+int html_write_fd(int fd, const char *data, size_t len);
+
+size_t html_escape_scan(const char *data, size_t len);
+
+size_t html_escaped_length(const char *data, size_t len);
+
+int html_writer_append_escaped(html_writer *writer, const char *data, size_t len);
+
+html_sink *html_sink_create(const html_sink_ops *ops, void *state);
+
+html_sink *html_sink_file(FILE *file, int close_file);
+
+html_sink *html_sink_fd(int fd, int close_fd);
+
+html_sink *html_sink_async(html_sink *inner, size_t buffer_size);
+
+int html_sink_write(void *sink, const char *data, size_t len);
+
+int html_sink_flush(html_sink *sink);
+
+void html_sink_close(html_sink *sink);
+
+int html_gzip_init(html_gzip_sink *sink, int level, html_writer_flush_fn flush, void *target);
+
+int html_gzip_set_level(html_gzip_sink *sink, int level);
+
+int html_gzip_write(void *sink, const char *data, size_t len);
+
+int html_gzip_finish(html_gzip_sink *sink);
+
+void html_gzip_free(html_gzip_sink *sink);
+
 void html_set_error(const char *format, ...);
 
+void html_set_error_ex(int code, const char *format, ...);
+
+void html_set_error_code(int code, const char *message);
+
+void html_set_error_tags(int code, const char *format, int first, int second);
+
 const char *html_get_error(void);
 
 const char *html_get_last_error(void);
 
+int html_get_error_code(void);
+
+const char *html_error_string(int code);
+
 void html_clear_error(void);
 
 id_map *html_create_id_map(int initial_capacity);
@@ -61,6 +518,48 @@ int html_resize_id_map(id_map *map);
 
 unsigned int html_code_string(const char *str);
 
+uint64_t html_hash_bytes(const void *data, size_t len);
+
+html_table *html_table_create(int initial_capacity);
+
+void html_table_free(html_table *table);
+
+void html_table_clear(html_table *table);
+
+void *html_table_get(const html_table *table, const char *key);
+
+int html_table_insert(html_table *table, const char *key, void *value);
+
+int html_table_remove(html_table *table, const char *key, const void *value);
+
+int html_table_grow(html_table *table);
+
+int html_name_table_find(const html_name_table *table, const char *name, size_t len);
+
+int html_name_table_intern(html_name_table *table, const char *name, size_t len);
+
+const char *html_name_table_get(const html_name_table *table, int index);
+
+int html_name_table_find_shared(const html_name_table *table, const char *name, size_t len);
+
+int html_name_table_intern_shared(html_name_table *table, const char *name, size_t len, const char **interned);
+
+const char *html_name_table_get_shared(const html_name_table *table, int index);
+
+void html_name_table_free(html_name_table *table);
+
+int html_tag_lookup(const char *name);
+
+int html_tag_intern(const char *name);
+
+const char *html_tag_name(int tag);
+
+int html_tag_is_block(int tag);
+
+int html_tag_is_self_closing(int tag);
+
+int html_tag_is_valid_child(int parent_tag, int child_tag);
+
 int html_is_valid_child(const char *parent_tag, const char *child_tag);
 
 int html_is_block_element(const char *tagname);
@@ -81,8 +580,38 @@ int html_render_element(html_context *ctx, html_element *element);
 
 html_context *html_init_file(const char *filename, const char *title);
 
+html_context *html_init_file_ex(const char *filename, const char *title, int flags);
+
+html_context *html_init_sink(html_sink *sink, const char *title);
+
+html_context *html_init_sink_ex(html_sink *sink, const char *title, int flags);
+
+html_context *html_init_string(const char *title);
+
+html_context *html_init_string_ex(const char *title, int flags);
+
+char *html_render_to_string(html_context *ctx);
+
+size_t html_render_length(html_context *ctx);
+
+char *html_render_to_string_ex(html_context *ctx, const html_render_options *options);
+
+size_t html_render_length_ex(html_context *ctx, const html_render_options *options);
+
+void html_render_options_init(html_render_options *options);
+
 void html_finalize(html_context *ctx);
 
+int html_context_reset(html_context *ctx, const char *title);
+
+html_context_pool *html_context_pool_create(int flags, int max_idle);
+
+html_context *html_context_pool_acquire(html_context_pool *pool, const char *title);
+
+void html_context_pool_release(html_context_pool *pool, html_context *ctx);
+
+void html_context_pool_free(html_context_pool *pool);
+
 int html_add_style(html_context *ctx, const char *style_content);
 
 int html_add_script(html_context *ctx, const char *script_content, int is_external);
@@ -111,14 +640,74 @@ int html_add_list_item(html_context *ctx, const char *content, const char *attri
 
 html_element *html_get_element_by_id(html_context *ctx, const char *id);
 
+html_element **html_get_elements_by_class(html_context *ctx, const char *classname, int *count);
+
+html_element **html_get_elements_by_tag(html_context *ctx, const char *tagname, int *count);
+
+html_element **html_get_elements_by_tag_id(html_context *ctx, int tag, int *count);
+
+int html_element_list_append(html_element_list *list, html_element *element);
+
+void html_element_list_remove_at(html_element_list *list, int slot);
+
+int html_index_element(html_context *ctx, html_element *element);
+
+void html_unindex_element(html_context *ctx, html_element *element);
+
+int html_index_class(html_context *ctx, html_element *element, const char *classname, size_t len);
+
+void html_unindex_class(html_context *ctx, html_element *element, const char *classname, size_t len);
+
+void html_index_classes(html_context *ctx, html_element *element);
+
+void html_unindex_classes(html_context *ctx, html_element *element);
+
+void html_reset_indexes(html_context *ctx);
+
+void html_free_indexes(html_context *ctx);
+
+html_selector *html_selector_compile(const char *selector);
+
+void html_selector_free(html_selector *selector);
+
+int html_selector_matches(const html_selector *selector, const html_element *element);
+
+html_element **html_selector_query_all(html_context *ctx, const html_selector *selector, int *count);
+
+html_element *html_selector_query(html_context *ctx, const html_selector *selector);
+
+html_element **html_query_selector_all(html_context *ctx, const char *selector, int *count);
+
+html_element *html_query_selector(html_context *ctx, const char *selector);
+
 int html_set_element_content(html_element *element, const char *content);
 
+int html_set_element_escape(html_element *element, int escape);
+
 int html_set_element_attribute(html_element *element, const char *name, const char *value);
 
 int html_add_class(html_element *element, const char *classname);
 
+int html_remove_class(html_element *element, const char *classname);
+
+int html_has_class(const html_element *element, const char *classname);
+
+const char *html_get_element_attribute(const html_element *element, const char *name);
+
+int html_remove_element_attribute(html_element *element, const char *name);
+
+const char *html_intern_attribute_name(const char *name, size_t len);
+
+int html_parse_attributes(html_element *element, const char *attributes);
+
+html_attribute *html_find_attribute(const html_element *element, const char *name);
+
+void html_free_attributes(html_element *element);
+
 int html_add_form(html_context *ctx, const char *action, const char *method, const char *attributes);
 
+int html_end_form(html_context *ctx);
+
 int html_add_input(html_context *ctx, const char *type, const char *name, const char *value, const char *attributes);
 
 int html_add_button(html_context *ctx, const char *type, const char *content, const char *attributes);
@@ -133,20 +722,112 @@ int html_end_table_row(html_context *ctx);
 
 int html_add_table_cell(html_context *ctx, const char *content, const char *attributes, int is_header);
 
+int html_add_table_bulk(html_context *ctx, const char *attributes, int nrows, int ncols,
+                        const char *const *const *data, const char *const *header);
+
+int html_add_table_bulk_cb(html_context *ctx, const char *attributes, int nrows, int ncols,
+                           html_table_cell_fn cell, void *user, const char *const *header);
+
+int html_add_table_columns(html_context *ctx, const char *attributes, int nrows,
+                           const html_table_column *columns, int ncols, int header_row);
+
+int html_format_int(char *buf, long long value);
+
+int html_format_double(char *buf, double value, int precision);
+
+int html_add_list_items(html_context *ctx, const char *const *items, int n, const char *attributes);
+
+int html_add_children_batch(html_context *ctx, html_element *parent, int tag, const char *const *contents, int n,
+                            const char *attributes);
+
 int html_add_meta(html_context *ctx, const char *name, const char *content);
 
 int html_add_link(html_context *ctx, const char *rel, const char *href, const char *type);
 
 int html_register_element_by_id(html_context *ctx, html_element *element);
 
+int html_unregister_element_by_id(html_context *ctx, html_element *element);
+
 html_element *html_add_child(html_context *ctx, html_element *parent, const char *tagname, const char *attributes, const char *content);
 
+html_element *html_add_child_tag(html_context *ctx, html_element *parent, int tag, const char *attributes, const char *content);
+
 int html_render(html_context *ctx);
 
+int html_render_ex(html_context *ctx, const html_render_options *options);
+
+int html_render_fd(html_context *ctx, int fd);
+
+int html_render_parallel(html_context *ctx, int nthreads);
+
+int html_render_fd_ex(html_context *ctx, int fd, const html_render_options *options);
+
+int html_render_gzip(html_context *ctx, FILE *file, int level);
+
+char *html_render_to_gzip(html_context *ctx, int level, size_t *length);
+
+int html_set_gzip_level(html_context *ctx, int level);
+
+html_render_cursor *html_render_begin(html_context *ctx);
+
+html_render_cursor *html_render_begin_ex(html_context *ctx, const html_render_options *options);
+
+size_t html_render_next_chunk(html_render_cursor *cursor, char *buf, size_t cap);
+
+int html_render_finished(const html_render_cursor *cursor);
+
+void html_render_end(html_render_cursor *cursor);
+
+int html_stream_element(html_context *ctx, html_element *element);
+
+void html_stream_free(html_context *ctx);
+
+void html_render_cache_free(html_context *ctx);
+
+int html_write_element(html_writer *writer, const html_element *element, int level);
+
+int html_write_element_ex(html_writer *writer, const html_element *element, int level,
+                          const html_render_options *options);
+
+html_patch *html_diff(html_context *old_ctx, html_context *new_ctx);
+
+char *html_patch_to_json(const html_patch *patch);
+
+void html_patch_free(html_patch *patch);
+
+html_template *html_template_compile(html_context *ctx);
+
+html_template *html_template_compile_ex(html_context *ctx, const html_render_options *options);
+
+int html_template_slot(const html_template *tpl, const char *name);
+
+int html_template_slot_count(const html_template *tpl);
+
+int html_template_render(const html_template *tpl, const char *const *values, html_sink *sink);
+
+char *html_template_render_to_string(const html_template *tpl, const char *const *values, size_t *length);
+
+void html_template_free(html_template *tpl);
+
+html_fragment *html_fragment_create(const html_element *root);
+
+html_element *html_fragment_instantiate(html_context *ctx, html_element *parent, html_fragment *frag,
+                                        const html_fragment_overrides *overrides);
+
+void html_fragment_free(html_fragment *frag);
+
 html_element *html_create_element(const char *tagname, const char *attributes, const char *content);
 
+html_element *html_create_element_in(html_context *ctx, const char *tagname, const char *attributes, const char *content);
+
+html_element *html_create_element_tag(html_context *ctx, int tag, const char *attributes, const char *content);
+
+int html_element_reserve_children(html_element *element, int capacity);
+
 void html_free_element(html_element *element);
 
+void html_mark_dirty(html_element *element);
+
 int html_set_current_element(html_context *ctx, html_element *element);
 
 int html_add_content(html_context *ctx, const char *content);
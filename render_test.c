@@ -0,0 +1,1390 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "HTML.h"
+#include "test_buffer.h"
+
+// every way of producing a document has to give the same bytes as a plain
+// render of the same tree
+
+static html_context *buffer_context(output_buffer *out, int flags)
+{
+    memset(out, 0, sizeof(*out));
+    html_sink *sink = html_sink_create(&buffer_ops, out);
+    return sink ? html_init_sink_ex(sink, "Render Test", flags) : NULL;
+}
+
+static void build_page(html_context *ctx, int rows)
+{
+    char attributes[64];
+    char content[64];
+
+    html_add_meta(ctx, "viewport", "width=device-width, initial-scale=1.0");
+    html_add_heading(ctx, 1, "Render <test> & \"quotes\"", "class='title'");
+
+    html_begin_section(ctx, "id='list' class='panel'");
+    html_begin_unordered_list(ctx, "class='items'");
+    for (int i = 0; i < rows; i++)
+    {
+        snprintf(content, sizeof(content), "Item %d", i);
+        html_add_list_item(ctx, content, i % 3 == 0 ? "class='odd'" : NULL);
+    }
+    html_end_list(ctx);
+    html_end_section(ctx);
+
+    html_begin_section(ctx, "id='table' class='panel'");
+    html_begin_table(ctx, "class='grid'");
+    for (int i = 0; i < rows; i++)
+    {
+        snprintf(attributes, sizeof(attributes), "id='row-%d'", i);
+        html_begin_table_row(ctx, attributes);
+        snprintf(content, sizeof(content), "%d", i);
+        html_add_table_cell(ctx, content, NULL, 0);
+        html_add_table_cell(ctx, "cell <b>", "class='text'", 0);
+        html_end_table_row(ctx);
+    }
+    html_end_table(ctx);
+    html_end_section(ctx);
+
+    html_begin_section(ctx, "id='nested'");
+    for (int depth = 0; depth < 20; depth++)
+        html_begin_section(ctx, "class='level'");
+    html_add_image(ctx, "logo.png", "Logo", NULL);
+    html_add_paragraph(ctx, NULL, "deep");
+    for (int depth = 0; depth < 20; depth++)
+        html_end_section(ctx);
+    html_end_section(ctx);
+
+    // long enough for descriptor renders to reference it instead of copying
+    char *long_text = (char *)malloc(rows * 16 + 1);
+    if (long_text)
+    {
+        for (int i = 0; i < rows * 16; i++)
+            long_text[i] = (char)('a' + i % 26);
+        long_text[rows * 16] = '\0';
+        html_add_paragraph(ctx, "class='long'", long_text);
+        free(long_text);
+    }
+
+    html_add_paragraph(ctx, "class='footer'", "The end");
+}
+
+static int check_equal(const char *name, const char *expected, size_t expected_length, const char *actual,
+                       size_t actual_length)
+{
+    if (!expected || !actual)
+    {
+        printf("FAIL %s: no output (%s)\n", name, html_get_error());
+        return 1;
+    }
+
+    if (expected_length != actual_length || memcmp(expected, actual, expected_length) != 0)
+    {
+        size_t at = 0;
+        while (at < expected_length && at < actual_length && expected[at] == actual[at])
+            at++;
+        printf("FAIL %s: %zu bytes expected, %zu rendered, first difference at %zu\n", name, expected_length,
+               actual_length, at);
+        return 1;
+    }
+
+    printf("ok   %s\n", name);
+    return 0;
+}
+
+// compares two rendered strings and frees them
+static int check_strings(const char *name, char *expected, char *actual)
+{
+    int failed = check_equal(name, expected, expected ? strlen(expected) : 0, actual, actual ? strlen(actual) : 0);
+    free(expected);
+    free(actual);
+    return failed;
+}
+
+// renders a freshly built page into a buffer; finalizing a sink context
+// renders it
+static int render_reference(output_buffer *out, int rows)
+{
+    html_context *ctx = buffer_context(out, 0);
+    if (!ctx)
+        return 0;
+
+    build_page(ctx, rows);
+    html_finalize(ctx);
+    return out->length > 0;
+}
+
+static int test_streaming(void)
+{
+    output_buffer expected;
+    output_buffer streamed;
+    int failures = 0;
+
+    if (!render_reference(&expected, 500))
+        return check_equal("streaming", NULL, 0, NULL, 0);
+
+    html_context *ctx = buffer_context(&streamed, HTML_CONTEXT_STREAMING);
+    if (ctx)
+    {
+        build_page(ctx, 500);
+        // closed sections are already written before the final render
+        if (streamed.length == 0)
+        {
+            printf("FAIL streaming: nothing written before html_render\n");
+            failures++;
+        }
+        // the render at finalize must not write the document a second time
+        html_render(ctx);
+        html_finalize(ctx);
+    }
+
+    failures += check_equal("streaming render matches plain render", expected.data, expected.length,
+                            streamed.data, streamed.length);
+    free(expected.data);
+    free(streamed.data);
+    return failures;
+}
+
+static int test_chunks(void)
+{
+    static const size_t sizes[] = {1, 7, 100, 4096, 1 << 20};
+    output_buffer expected;
+    int failures = 0;
+
+    if (!render_reference(&expected, 500))
+        return check_equal("chunked render", NULL, 0, NULL, 0);
+
+    html_context *ctx = html_init_string("Render Test");
+    if (!ctx)
+        return check_equal("chunked render", NULL, 0, NULL, 0);
+    build_page(ctx, 500);
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+    {
+        output_buffer chunked;
+        memset(&chunked, 0, sizeof(chunked));
+
+        char *chunk = (char *)malloc(sizes[s]);
+        html_render_cursor *cursor = chunk ? html_render_begin(ctx) : NULL;
+        while (cursor && !html_render_finished(cursor))
+        {
+            size_t len = html_render_next_chunk(cursor, chunk, sizes[s]);
+            if (len == 0 && !html_render_finished(cursor))
+                break;
+            buffer_write(&chunked, chunk, len);
+        }
+        html_render_end(cursor);
+        free(chunk);
+
+        char name[64];
+        snprintf(name, sizeof(name), "chunked render, %zu byte chunks", sizes[s]);
+        failures += check_equal(name, expected.data, expected.length, chunked.data, chunked.length);
+        free(chunked.data);
+    }
+
+    html_finalize(ctx);
+    free(expected.data);
+    return failures;
+}
+
+static int test_fd(void)
+{
+    output_buffer expected;
+    output_buffer written;
+    memset(&written, 0, sizeof(written));
+
+    if (!render_reference(&expected, 500))
+        return check_equal("descriptor render", NULL, 0, NULL, 0);
+
+    html_context *ctx = html_init_string("Render Test");
+    FILE *file = tmpfile();
+    if (ctx && file)
+    {
+        build_page(ctx, 500);
+        if (html_render_fd(ctx, fileno(file)))
+        {
+            char chunk[4096];
+            size_t len;
+            rewind(file);
+            while ((len = fread(chunk, 1, sizeof(chunk), file)) > 0)
+                buffer_write(&written, chunk, len);
+        }
+    }
+    if (file)
+        fclose(file);
+    html_finalize(ctx);
+
+    int failures = check_equal("descriptor render matches plain render", expected.data, expected.length,
+                               written.data, written.length);
+    free(expected.data);
+    free(written.data);
+    return failures;
+}
+
+static int test_parallel(void)
+{
+    static const int thread_counts[] = {2, 4, 8};
+    output_buffer expected;
+    int failures = 0;
+
+    if (!render_reference(&expected, 2000))
+        return check_equal("parallel render", NULL, 0, NULL, 0);
+
+    for (size_t t = 0; t < sizeof(thread_counts) / sizeof(thread_counts[0]); t++)
+    {
+        output_buffer parallel;
+        html_context *ctx = buffer_context(&parallel, 0);
+        if (ctx)
+        {
+            build_page(ctx, 2000);
+            html_render_parallel(ctx, thread_counts[t]);
+            html_finalize(ctx);
+        }
+
+        char name[64];
+        snprintf(name, sizeof(name), "parallel render, %d threads", thread_counts[t]);
+        failures += check_equal(name, expected.data, expected.length, parallel.data, parallel.length);
+        free(parallel.data);
+    }
+
+    free(expected.data);
+    return failures;
+}
+
+// one round of edits through the functions that mark elements dirty
+static void mutate_page(html_context *ctx, int round)
+{
+    char id[32];
+    char content[64];
+
+    snprintf(id, sizeof(id), "row-%d", round * 7);
+    html_element *row = html_get_element_by_id(ctx, id);
+    if (row)
+    {
+        html_add_class(row, "changed");
+        snprintf(content, sizeof(content), "edited in round %d", round);
+        html_set_element_content(row->children[1], content);
+    }
+
+    snprintf(id, sizeof(id), "row-%d", round * 7 + 3);
+    html_element *removed = html_get_element_by_id(ctx, id);
+    if (removed)
+        html_free_element(removed);
+
+    html_element *list = html_get_element_by_id(ctx, "list");
+    if (list)
+    {
+        html_set_element_attribute(list, "data-round", round % 2 ? "odd" : "even");
+        html_add_child(ctx, list, "p", "class='note'", "added later");
+    }
+
+    html_element *nested = html_get_element_by_id(ctx, "nested");
+    if (nested && round == 2)
+        html_set_element_content(nested, "collapsed");
+}
+
+static int test_render_cache(void)
+{
+    html_context *cached = html_init_string_ex("Render Test", HTML_CONTEXT_RENDER_CACHE);
+    html_context *fresh = html_init_string("Render Test");
+    int failures = 0;
+
+    if (!cached || !fresh)
+    {
+        html_finalize(cached);
+        html_finalize(fresh);
+        return check_equal("render cache", NULL, 0, NULL, 0);
+    }
+
+    build_page(cached, 100);
+    build_page(fresh, 100);
+
+    for (int round = 0; round < 4; round++)
+    {
+        if (round > 0)
+        {
+            mutate_page(cached, round);
+            mutate_page(fresh, round);
+        }
+
+        char name[64];
+        snprintf(name, sizeof(name), "cached render after %d round(s) of edits", round);
+        failures += check_strings(name, html_render_to_string(fresh), html_render_to_string(cached));
+    }
+
+    html_finalize(cached);
+    html_finalize(fresh);
+    return failures;
+}
+
+// the number formatters have to give the same text as printf
+static int test_number_format(void)
+{
+    static const long long integers[] = {0, 7, -7, 99, 100, -1000000007LL, 9223372036854775807LL,
+                                         -9223372036854775807LL - 1};
+    static const double doubles[] = {0.0, -0.0, 0.1, -0.001, 0.125, 2.5, -2.5, 1.005, 2.675, 123456.789,
+                                     999999.9999999, 1e15, -1e15, 1e20, 1e-20, 1.7976931348623157e308, 5e-324};
+    char buf[HTML_NUMBER_BUFFER_SIZE];
+    char expected[HTML_NUMBER_BUFFER_SIZE];
+    int mismatches = 0;
+
+    for (size_t i = 0; i < sizeof(integers) / sizeof(integers[0]); i++)
+    {
+        int len = html_format_int(buf, integers[i]);
+        int want = snprintf(expected, sizeof(expected), "%lld", integers[i]);
+        if (len != want || strcmp(buf, expected) != 0)
+        {
+            printf("FAIL format %lld: \"%s\", printf gives \"%s\"\n", integers[i], buf, expected);
+            mismatches++;
+        }
+    }
+
+    for (size_t i = 0; i < sizeof(doubles) / sizeof(doubles[0]); i++)
+    {
+        for (int precision = 0; precision <= HTML_NUMBER_MAX_PRECISION; precision++)
+        {
+            int len = html_format_double(buf, doubles[i], precision);
+            int want = snprintf(expected, sizeof(expected), "%.*f", precision, doubles[i]);
+            if (len != want || strcmp(buf, expected) != 0)
+            {
+                printf("FAIL format %.17g, precision %d: \"%s\", printf gives \"%s\"\n", doubles[i], precision, buf,
+                       expected);
+                mismatches++;
+            }
+        }
+    }
+
+    if (mismatches)
+        return 1;
+    printf("ok   number formatting matches printf\n");
+    return 0;
+}
+
+#define BULK_ROWS 40
+#define BULK_COLUMNS 4
+
+typedef struct
+{
+    const char *names[BULK_ROWS];
+    long long counts[BULK_ROWS];
+    double prices[BULK_ROWS];
+    double ratios[BULK_ROWS];
+    char text[BULK_ROWS][BULK_COLUMNS][HTML_NUMBER_BUFFER_SIZE];
+    const char *cells[BULK_ROWS][BULK_COLUMNS];
+    const char *const *rows[BULK_ROWS];
+} bulk_data;
+
+static const char *const bulk_header[BULK_COLUMNS] = {"Name", "Count", "Price", "Ratio"};
+
+static void bulk_fill(bulk_data *data)
+{
+    static const double large[] = {1e15, 1e20, -2.5, 0.125};
+
+    for (int row = 0; row < BULK_ROWS; row++)
+    {
+        data->names[row] = row % 7 == 3 ? NULL : (row % 2 ? "<odd> & \"row\"" : "even");
+        data->counts[row] = (row - 20) * 1000003LL;
+        data->prices[row] = row < 4 ? large[row] : row * 1.005;
+        data->ratios[row] = 0.1 * row;
+
+        // the cell text printf gives, for the tables built from strings
+        if (data->names[row])
+            snprintf(data->text[row][0], HTML_NUMBER_BUFFER_SIZE, "%s", data->names[row]);
+        snprintf(data->text[row][1], HTML_NUMBER_BUFFER_SIZE, "%lld", data->counts[row]);
+        snprintf(data->text[row][2], HTML_NUMBER_BUFFER_SIZE, "%.2f", data->prices[row]);
+        snprintf(data->text[row][3], HTML_NUMBER_BUFFER_SIZE, "%.12f", data->ratios[row]);
+
+        for (int column = 0; column < BULK_COLUMNS; column++)
+            data->cells[row][column] = column == 0 && !data->names[row] ? NULL : data->text[row][column];
+        data->rows[row] = data->cells[row];
+    }
+}
+
+static const char *bulk_cell(void *user, int row, int column)
+{
+    return ((bulk_data *)user)->cells[row][column];
+}
+
+// every bulk builder has to give the same document as the cell-by-cell calls
+static int test_bulk_tables(void)
+{
+    static bulk_data data;
+    bulk_fill(&data);
+    int failures = 0;
+
+    html_context *ctx = html_init_string("Bulk Test");
+    if (ctx)
+    {
+        html_begin_table(ctx, "class='bulk'");
+        html_begin_table_row(ctx, NULL);
+        for (int column = 0; column < BULK_COLUMNS; column++)
+            html_add_table_cell(ctx, bulk_header[column], NULL, 1);
+        html_end_table_row(ctx);
+        for (int row = 0; row < BULK_ROWS; row++)
+        {
+            html_begin_table_row(ctx, NULL);
+            for (int column = 0; column < BULK_COLUMNS; column++)
+                html_add_table_cell(ctx, data.cells[row][column], NULL, 0);
+            html_end_table_row(ctx);
+        }
+        html_end_table(ctx);
+    }
+    char *expected = ctx ? html_render_to_string(ctx) : NULL;
+    html_finalize(ctx);
+
+    const html_table_column columns[BULK_COLUMNS] = {
+        {"Name", HTML_COLUMN_TEXT, data.names, 0},
+        {"Count", HTML_COLUMN_INT, data.counts, 0},
+        {"Price", HTML_COLUMN_DOUBLE, data.prices, 2},
+        {"Ratio", HTML_COLUMN_DOUBLE, data.ratios, 12},
+    };
+
+    for (int builder = 0; builder < 3; builder++)
+    {
+        static const char *const names[] = {"bulk table from rows", "bulk table from a callback",
+                                            "bulk table from columns"};
+        ctx = html_init_string("Bulk Test");
+        if (ctx && builder == 0)
+            html_add_table_bulk(ctx, "class='bulk'", BULK_ROWS, BULK_COLUMNS, data.rows, bulk_header);
+        else if (ctx && builder == 1)
+            html_add_table_bulk_cb(ctx, "class='bulk'", BULK_ROWS, BULK_COLUMNS, bulk_cell, &data, bulk_header);
+        else if (ctx)
+            html_add_table_columns(ctx, "class='bulk'", BULK_ROWS, columns, BULK_COLUMNS, 1);
+
+        char *actual = ctx ? html_render_to_string(ctx) : NULL;
+        html_finalize(ctx);
+        failures += check_strings(names[builder], expected ? html_strdup(expected) : NULL, actual);
+    }
+
+    free(expected);
+    return failures;
+}
+
+// a template filled with values has to give the page built with those
+// values in place
+static int test_template(void)
+{
+    html_context *skeleton = html_init_string("Template Test");
+    html_context *filled = html_init_string("Template Test");
+    if (!skeleton || !filled)
+    {
+        html_finalize(skeleton);
+        html_finalize(filled);
+        return check_equal("template", NULL, 0, NULL, 0);
+    }
+
+    html_add_script(skeleton, "var o={{a}};", 0);
+    html_add_paragraph(skeleton, "class='{{cls}}' title='{{ user }}'", "Hello {{user}}!");
+    html_add_paragraph(skeleton, NULL, "{{{markup}}}");
+    html_add_paragraph(skeleton, NULL, "[{{missing}}]");
+    html_add_paragraph(skeleton, NULL, "{{not closed} {{}} {x}");
+    html_add_script(filled, "var o={{a}};", 0);
+    html_add_paragraph(filled, "class='card wide' title='&lt;Ann&gt; &amp; &quot;Bo&quot;'",
+                       "Hello &lt;Ann&gt; &amp; &quot;Bo&quot;!");
+    html_add_paragraph(filled, NULL, "<b>bold</b>");
+    html_add_paragraph(filled, NULL, "[]");
+    html_add_paragraph(filled, NULL, "{{not closed} {{}} {x}");
+
+    int failures = 0;
+    html_template *tpl = html_template_compile(skeleton);
+    if (!tpl || html_template_slot_count(tpl) != 4 || html_template_slot(tpl, "a") != -1)
+    {
+        printf("FAIL template slots: %d found, script braces %s\n", tpl ? html_template_slot_count(tpl) : -1,
+               tpl && html_template_slot(tpl, "a") != -1 ? "taken as a slot" : "kept");
+        failures++;
+    }
+
+    char *expected = html_render_to_string(filled);
+    char *actual = NULL;
+    if (tpl)
+    {
+        const char *values[4] = {NULL, NULL, NULL, NULL};
+        values[html_template_slot(tpl, "cls")] = "card wide";
+        values[html_template_slot(tpl, "user")] = "<Ann> & \"Bo\"";
+        values[html_template_slot(tpl, "markup")] = "<b>bold</b>";
+        actual = html_template_render_to_string(tpl, values, NULL);
+    }
+    failures += check_strings("template render matches the filled page", expected, actual);
+
+    html_template_free(tpl);
+    html_finalize(skeleton);
+    html_finalize(filled);
+    return failures;
+}
+
+// a model of the client-side document the diff tests apply patches to; an
+// inserted subtree is kept as the HTML the patch carried
+typedef struct patch_node
+{
+    const char *tagname;
+    int self_closing;
+    char *html;
+    char *content;
+    char *names[8];
+    char *values[8];
+    unsigned char quotes[8];
+    int attribute_count;
+    struct patch_node **children;
+    int children_count;
+    struct patch_node *parent;
+} patch_node;
+
+typedef struct
+{
+    patch_node *root;
+    patch_node *detached[16];
+    int detached_count;
+} patch_document;
+
+static char *copy_string(const char *str)
+{
+    return str ? html_strdup(str) : NULL;
+}
+
+static void patch_node_free(patch_node *node)
+{
+    if (!node)
+        return;
+
+    for (int i = 0; i < node->children_count; i++)
+        patch_node_free(node->children[i]);
+    for (int i = 0; i < node->attribute_count; i++)
+    {
+        free(node->names[i]);
+        free(node->values[i]);
+    }
+    free(node->children);
+    free(node->content);
+    free(node->html);
+    free(node);
+}
+
+static int patch_node_insert(patch_node *parent, patch_node *child, int index)
+{
+    if (index < 0 || index > parent->children_count)
+        return 0;
+
+    patch_node **children =
+        (patch_node **)realloc(parent->children, (parent->children_count + 1) * sizeof(patch_node *));
+    if (!children)
+        return 0;
+
+    memmove(children + index + 1, children + index, (parent->children_count - index) * sizeof(patch_node *));
+    children[index] = child;
+    parent->children = children;
+    parent->children_count++;
+    child->parent = parent;
+    return 1;
+}
+
+static void patch_node_detach(patch_node *child)
+{
+    patch_node *parent = child->parent;
+    if (!parent)
+        return;
+
+    for (int i = 0; i < parent->children_count; i++)
+    {
+        if (parent->children[i] == child)
+        {
+            memmove(parent->children + i, parent->children + i + 1,
+                    (parent->children_count - i - 1) * sizeof(patch_node *));
+            parent->children_count--;
+            break;
+        }
+    }
+    child->parent = NULL;
+}
+
+static int patch_node_attribute(const patch_node *node, const char *name)
+{
+    for (int i = 0; i < node->attribute_count; i++)
+    {
+        if (strcmp(node->names[i], name) == 0)
+            return i;
+    }
+    return -1;
+}
+
+static patch_node *patch_node_create(const html_element *element)
+{
+    patch_node *node = (patch_node *)calloc(1, sizeof(patch_node));
+    if (!node)
+        return NULL;
+
+    node->tagname = element->tagname;
+    node->self_closing = html_tag_is_self_closing(element->tag);
+    node->content = copy_string(element->content);
+    for (int i = 0; i < element->attribute_count && i < 8; i++)
+    {
+        node->names[i] = copy_string(element->attributes[i].name);
+        node->values[i] = copy_string(element->attributes[i].value);
+        node->quotes[i] = element->attributes[i].quote;
+        node->attribute_count++;
+    }
+
+    for (int i = 0; i < element->children_count; i++)
+    {
+        patch_node *child = patch_node_create(element->children[i]);
+        if (!child || !patch_node_insert(node, child, node->children_count))
+        {
+            patch_node_free(child);
+            patch_node_free(node);
+            return NULL;
+        }
+    }
+    return node;
+}
+
+static patch_node *patch_node_find(patch_node *node, const char *id)
+{
+    int slot = node->html ? -1 : patch_node_attribute(node, "id");
+    if (slot >= 0 && node->values[slot] && strcmp(node->values[slot], id) == 0)
+        return node;
+
+    for (int i = 0; i < node->children_count; i++)
+    {
+        patch_node *found = patch_node_find(node->children[i], id);
+        if (found)
+            return found;
+    }
+    return NULL;
+}
+
+// looks in the document first, then among the detached elements
+static patch_node *patch_document_find(patch_document *doc, const char *id, int take)
+{
+    patch_node *found = id ? patch_node_find(doc->root, id) : NULL;
+    for (int i = 0; !found && id && i < doc->detached_count; i++)
+    {
+        found = patch_node_find(doc->detached[i], id);
+        if (found && take && found == doc->detached[i])
+            doc->detached[i] = doc->detached[--doc->detached_count];
+    }
+    return found;
+}
+
+static int patch_apply_op(patch_document *doc, const html_patch_op *op)
+{
+    if (op->type == HTML_PATCH_DETACH_CHILD)
+    {
+        patch_node *node = patch_document_find(doc, op->id, 0);
+        if (!node || doc->detached_count == 16)
+            return 0;
+        patch_node_detach(node);
+        doc->detached[doc->detached_count++] = node;
+        return 1;
+    }
+
+    patch_node *target = doc->root;
+    for (int i = 0; i < op->path_length; i++)
+    {
+        if (target->html || op->path[i] < 0 || op->path[i] >= target->children_count)
+            return 0;
+        target = target->children[op->path[i]];
+    }
+    if (target->html)
+        return 0;
+
+    int slot = op->name ? patch_node_attribute(target, op->name) : -1;
+    switch (op->type)
+    {
+    case HTML_PATCH_SET_CONTENT:
+        // like innerHTML, the text replaces whatever the element held
+        while (target->children_count > 0)
+        {
+            patch_node *child = target->children[target->children_count - 1];
+            patch_node_detach(child);
+            patch_node_free(child);
+        }
+        free(target->content);
+        target->content = copy_string(op->value);
+        return 1;
+    case HTML_PATCH_SET_ATTRIBUTE:
+        if (slot < 0)
+        {
+            if (target->attribute_count == 8)
+                return 0;
+            slot = target->attribute_count++;
+            target->names[slot] = copy_string(op->name);
+            target->quotes[slot] = '"';
+        }
+        else
+        {
+            free(target->values[slot]);
+        }
+        target->values[slot] = copy_string(op->value);
+        return 1;
+    case HTML_PATCH_REMOVE_ATTRIBUTE:
+        if (slot < 0)
+            return 0;
+        free(target->names[slot]);
+        free(target->values[slot]);
+        target->attribute_count--;
+        memmove(target->names + slot, target->names + slot + 1, (target->attribute_count - slot) * sizeof(char *));
+        memmove(target->values + slot, target->values + slot + 1, (target->attribute_count - slot) * sizeof(char *));
+        memmove(target->quotes + slot, target->quotes + slot + 1, target->attribute_count - slot);
+        return 1;
+    case HTML_PATCH_INSERT_CHILD:
+    {
+        patch_node *child = (patch_node *)calloc(1, sizeof(patch_node));
+        if (!child || !(child->html = copy_string(op->value)) || !patch_node_insert(target, child, op->index))
+        {
+            patch_node_free(child);
+            return 0;
+        }
+        return 1;
+    }
+    case HTML_PATCH_REMOVE_CHILD:
+    {
+        if (op->index < 0 || op->index >= target->children_count)
+            return 0;
+        patch_node *child = target->children[op->index];
+        patch_node_detach(child);
+        patch_node_free(child);
+        return 1;
+    }
+    case HTML_PATCH_MOVE_CHILD:
+    {
+        patch_node *node = patch_document_find(doc, op->value, 1);
+        if (!node)
+            return 0;
+        patch_node_detach(node);
+        return patch_node_insert(target, node, op->index);
+    }
+    default:
+        return 0;
+    }
+}
+
+// the model written out the way a minified render writes elements
+static void patch_node_write(html_writer *writer, const patch_node *node)
+{
+    if (node->html)
+    {
+        html_writer_puts(writer, node->html);
+        return;
+    }
+
+    html_writer_putc(writer, '<');
+    html_writer_puts(writer, node->tagname);
+    for (int i = 0; i < node->attribute_count; i++)
+    {
+        html_writer_putc(writer, ' ');
+        html_writer_puts(writer, node->names[i]);
+        if (!node->values[i])
+            continue;
+        html_writer_putc(writer, '=');
+        if (node->quotes[i])
+            html_writer_putc(writer, (char)node->quotes[i]);
+        html_writer_puts(writer, node->values[i]);
+        if (node->quotes[i])
+            html_writer_putc(writer, (char)node->quotes[i]);
+    }
+    html_writer_putc(writer, '>');
+    if (node->self_closing)
+        return;
+
+    if (node->content && node->content[0])
+        html_writer_puts(writer, node->content);
+    else
+    {
+        for (int i = 0; i < node->children_count; i++)
+            patch_node_write(writer, node->children[i]);
+    }
+
+    html_writer_append(writer, "</", 2);
+    html_writer_puts(writer, node->tagname);
+    html_writer_putc(writer, '>');
+}
+
+static char *write_minified(const html_element *element, const patch_node *node)
+{
+    html_writer writer;
+    if (!html_writer_init(&writer, 4096, NULL, NULL))
+        return NULL;
+
+    html_render_options options;
+    html_render_options_init(&options);
+    options.flags = HTML_RENDER_MINIFIED;
+
+    if (element)
+        html_write_element_ex(&writer, element, 0, &options);
+    else
+        patch_node_write(&writer, node);
+
+    if (!html_writer_putc(&writer, '\0') || writer.error)
+    {
+        html_writer_free(&writer);
+        return NULL;
+    }
+    return writer.data;
+}
+
+static html_element *add(html_context *ctx, html_element *parent, const char *tagname, const char *attributes,
+                         const char *content)
+{
+    return parent ? html_add_child(ctx, parent, tagname, attributes, content) : NULL;
+}
+
+// two versions of each page; every change goes through the patch in both
+// directions
+static void diff_unkeyed_reorder(html_context *ctx, html_element *body, int version)
+{
+    static const char *const items[2][3] = {{"one", "two", "three"}, {"three", "one", "two"}};
+    html_element *list = add(ctx, body, "ul", "class=\"items\"", NULL);
+    for (int i = 0; i < 3; i++)
+        add(ctx, list, "li", NULL, items[version][i]);
+
+    html_element *mixed = add(ctx, body, "div", version ? "class=\"mixed wide\"" : "class=\"mixed\"", NULL);
+    add(ctx, mixed, version ? "span" : "p", NULL, version ? "b" : "a");
+    add(ctx, mixed, version ? "p" : "span", NULL, version ? "c" : "b");
+    add(ctx, mixed, "p", NULL, version ? "a" : "c");
+}
+
+static void diff_keyed_move(html_context *ctx, html_element *body, int version)
+{
+    html_element *first = add(ctx, body, "section", "id=\"first\"", NULL);
+    add(ctx, first, "p", NULL, "x");
+    if (!version)
+        add(ctx, add(ctx, first, "div", "id=\"card\" class=\"card\"", NULL), "p", NULL, "card body");
+
+    html_element *second = add(ctx, body, "section", "id=\"second\"", NULL);
+    add(ctx, second, "p", NULL, "y");
+    if (version)
+        add(ctx, add(ctx, second, "div", "id=\"card\" class=\"card\"", NULL), "p", NULL, "card body");
+}
+
+static void diff_swap_nesting(html_context *ctx, html_element *body, int version)
+{
+    html_element *outer = add(ctx, body, "div", version ? "id=\"inner\" class=\"i\"" : "id=\"outer\" class=\"o\"", NULL);
+    html_element *inner = add(ctx, outer, "div", version ? "id=\"outer\" class=\"o\"" : "id=\"inner\" class=\"i\"", NULL);
+    add(ctx, inner, "p", NULL, "deep");
+    add(ctx, body, "p", NULL, "after");
+}
+
+static void diff_content_switch(html_context *ctx, html_element *body, int version)
+{
+    html_element *box = add(ctx, body, "div", "id=\"box\"", version ? NULL : "plain text");
+    if (version)
+    {
+        add(ctx, box, "p", NULL, "1");
+        add(ctx, box, "span", NULL, "2");
+    }
+
+    html_element *list = add(ctx, body, "div", "class=\"list\"", version ? "collapsed" : NULL);
+    if (!version)
+    {
+        add(ctx, list, "p", NULL, "1");
+        add(ctx, list, "p", "id=\"kept\"", "2");
+    }
+    else
+    {
+        add(ctx, body, "p", "id=\"kept\"", "2");
+    }
+}
+
+static void diff_removed_subtree(html_context *ctx, html_element *body, int version)
+{
+    if (!version)
+    {
+        html_element *gone = add(ctx, body, "section", "id=\"gone\"", NULL);
+        html_element *wrapper = add(ctx, gone, "div", NULL, NULL);
+        add(ctx, wrapper, "span", "id=\"keep\"", "k");
+        add(ctx, wrapper, "p", NULL, "z");
+    }
+
+    html_element *tail = add(ctx, body, "div", "id=\"tail\"", NULL);
+    add(ctx, tail, "p", NULL, "end");
+    if (version)
+        add(ctx, tail, "span", "id=\"keep\"", "k");
+}
+
+typedef void (*diff_page_fn)(html_context *ctx, html_element *body, int version);
+
+// applies the patch from one version to the other and compares the result
+// with the target page
+static int check_diff(const char *name, diff_page_fn page, int from, int expect_move)
+{
+    html_context *old_ctx = html_init_string("Diff Test");
+    html_context *new_ctx = html_init_string("Diff Test");
+    if (old_ctx)
+        page(old_ctx, old_ctx->current, from);
+    if (new_ctx)
+        page(new_ctx, new_ctx->current, !from);
+
+    html_patch *patch = old_ctx && new_ctx ? html_diff(old_ctx, new_ctx) : NULL;
+    patch_document doc = {patch ? patch_node_create(old_ctx->root) : NULL, {NULL}, 0};
+
+    int applied = doc.root != NULL;
+    int moves = 0;
+    for (int i = 0; applied && i < patch->count; i++)
+    {
+        applied = patch_apply_op(&doc, &patch->ops[i]);
+        moves += patch->ops[i].type == HTML_PATCH_MOVE_CHILD;
+    }
+
+    int failures = 0;
+    if (!applied || doc.detached_count > 0 || (expect_move && !moves))
+    {
+        char *json = patch ? html_patch_to_json(patch) : NULL;
+        printf("FAIL %s: patch %s\n%s\n", name,
+               !applied ? "does not apply" : doc.detached_count ? "leaves elements detached" : "has no move",
+               json ? json : html_get_error());
+        free(json);
+        failures++;
+    }
+    else
+    {
+        failures += check_strings(name, write_minified(new_ctx->root, NULL), write_minified(NULL, doc.root));
+    }
+
+    for (int i = 0; i < doc.detached_count; i++)
+        patch_node_free(doc.detached[i]);
+    patch_node_free(doc.root);
+    html_patch_free(patch);
+    html_finalize(old_ctx);
+    html_finalize(new_ctx);
+    return failures;
+}
+
+static int test_diff(void)
+{
+    static const struct
+    {
+        const char *name;
+        diff_page_fn page;
+        int moves;
+    } cases[] = {
+        // bit 0 and 1: a keyed element has to move forward, backward; one
+        // that lands in an inserted subtree arrives with it instead
+        {"unkeyed reorder", diff_unkeyed_reorder, 0},
+        {"keyed move across parents", diff_keyed_move, 3},
+        {"keyed elements swapping nesting", diff_swap_nesting, 3},
+        {"switch between content and children", diff_content_switch, 1},
+        {"removed subtree holding a moved element", diff_removed_subtree, 1},
+    };
+    int failures = 0;
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    {
+        for (int from = 0; from < 2; from++)
+        {
+            char name[96];
+            snprintf(name, sizeof(name), "diff patch, %s, %s", cases[i].name, from ? "backward" : "forward");
+            failures += check_diff(name, cases[i].page, from, cases[i].moves & (1 << from));
+        }
+    }
+    return failures;
+}
+
+// the byte-at-a-time escape the vector scans have to agree with
+static size_t reference_escape(char *out, const char *data, size_t len)
+{
+    size_t length = 0;
+    for (size_t i = 0; i < len; i++)
+    {
+        const char *entity = NULL;
+        switch (data[i])
+        {
+        case '&':
+            entity = "&amp;";
+            break;
+        case '<':
+            entity = "&lt;";
+            break;
+        case '>':
+            entity = "&gt;";
+            break;
+        case '"':
+            entity = "&quot;";
+            break;
+        case '\'':
+            entity = "&#39;";
+            break;
+        }
+
+        if (entity)
+        {
+            memcpy(out + length, entity, strlen(entity));
+            length += strlen(entity);
+        }
+        else
+        {
+            out[length++] = data[i];
+        }
+    }
+    return length;
+}
+
+// every length up to 80, across the 16 and 32 byte vector widths, with a
+// special character at each position over filler that includes bytes from
+// 0x80 up and characters one bit away from the special ones
+static int test_escape(void)
+{
+    static const char specials[] = "&<>\"'=?%$";
+    static const unsigned char filler[] = {'a', 0x80, '=', 0xff, '?', 0xbc, '.', '$', 0xa6, '%', 0xfe, '#', '7'};
+    char data[96];
+    char expected[96 * 6];
+    int mismatches = 0;
+
+    for (size_t len = 0; len <= 80; len++)
+    {
+        for (size_t pos = 0; pos <= len; pos++)
+        {
+            for (size_t s = 0; s < sizeof(specials) - 1; s++)
+            {
+                // pos == len leaves the text without a special character
+                for (size_t i = 0; i < len; i++)
+                    data[i] = (char)filler[(i + s) % sizeof(filler)];
+                if (pos < len)
+                    data[pos] = specials[s];
+                // a second special character after the first one
+                if (pos + 17 < len)
+                    data[pos + 17] = '<';
+
+                size_t length = reference_escape(expected, data, len);
+                size_t first = 0;
+                while (first < len && !strchr("&<>\"'", data[first]))
+                    first++;
+
+                html_writer writer;
+                if (!html_writer_init(&writer, 16, NULL, NULL))
+                    return check_equal("escape", NULL, 0, NULL, 0);
+                html_writer_append_escaped(&writer, data, len);
+
+                if (html_escape_scan(data, len) != first || html_escaped_length(data, len) != length ||
+                    writer.error || writer.length != length || memcmp(writer.data, expected, length) != 0)
+                {
+                    if (mismatches++ < 5)
+                        printf("FAIL escape: length %zu, '%c' at %zu\n", len, specials[s], pos);
+                }
+                html_writer_free(&writer);
+            }
+        }
+    }
+
+    if (mismatches)
+        return 1;
+    printf("ok   escape matches a scalar escape at every length up to 80\n");
+    return 0;
+}
+
+static void collect_elements(html_element *element, html_element **all, int *count)
+{
+    all[(*count)++] = element;
+    for (int i = 0; i < element->children_count; i++)
+        collect_elements(element->children[i], all, count);
+}
+
+// runs a selector and lists the IDs of the matches; every element the plain
+// match test accepts must be found as well, whatever subtree the query scans
+static int check_selector(html_context *ctx, const char *text, const char *expected)
+{
+    html_element *all[64];
+    int total = 0;
+    collect_elements(ctx->root, all, &total);
+
+    char name[96];
+    snprintf(name, sizeof(name), "selector %s", text);
+
+    html_selector *selector = html_selector_compile(text);
+    int count = 0;
+    html_element **matches = selector ? html_selector_query_all(ctx, selector, &count) : NULL;
+
+    char found[256] = "";
+    char reference[256] = "";
+    for (int i = 0; i < count; i++)
+    {
+        strcat(found, i ? " " : "");
+        strcat(found, matches[i]->id ? matches[i]->id : "?");
+    }
+    for (int i = 0; selector && i < total; i++)
+    {
+        if (!html_selector_matches(selector, all[i]))
+            continue;
+        strcat(reference, reference[0] ? " " : "");
+        strcat(reference, all[i]->id ? all[i]->id : "?");
+    }
+
+    free(matches);
+    html_selector_free(selector);
+
+    if (!selector || strcmp(found, reference) != 0)
+    {
+        printf("FAIL %s: query found \"%s\", matching every element gives \"%s\"\n", name, found, reference);
+        return 1;
+    }
+    return check_equal(name, expected, strlen(expected), found, strlen(found));
+}
+
+static int test_selectors(void)
+{
+    html_context *ctx = html_init_string("Selector Test");
+    if (!ctx)
+        return check_equal("selectors", NULL, 0, NULL, 0);
+
+    // body > div#outer > (section#s1 > div#inner > p#p1, div#d2 > p#p2);
+    // body > div#list > span#a, span#b, em#c, span#d; body > p#p3
+    html_element *body = ctx->current;
+    html_element *outer = add(ctx, body, "div", "id='outer' class='box'", NULL);
+    html_element *inner = add(ctx, add(ctx, outer, "section", "id='s1'", NULL), "div", "id='inner' class='box'", NULL);
+    add(ctx, inner, "p", "id='p1'", "first");
+    add(ctx, add(ctx, outer, "div", "id='d2'", NULL), "p", "id='p2'", "second");
+    html_element *list = add(ctx, body, "div", "id='list'", NULL);
+    add(ctx, list, "span", "id='a' lang='en-US' class='x y'", "a");
+    add(ctx, list, "span", "id='b' lang='en' class='xy'", "b");
+    add(ctx, list, "em", "id='c' lang='english' class='y x z'", "c");
+    add(ctx, list, "span", "id='d' lang='fr'", "d");
+    add(ctx, body, "p", "id='p3'", "third");
+
+    static const char *const cases[][2] = {
+        // the nearest div above p1 is not a child of body, an outer one is
+        {"body > div p", "p1 p2"},
+        {"#outer > div > p", "p2"},
+        {"section div p", "p1"},
+        {"div#outer section > div.box p", "p1"},
+        {"div div p", "p1 p2"},
+        // sibling steps next to an ID leave the subtree of the ID match
+        {"#a + span", "b"},
+        {"#a ~ span", "b d"},
+        {"#b ~ *", "c d"},
+        {"#a + em", ""},
+        {"span#a ~ em", "c"},
+        {"#list > #a ~ span", "b d"},
+        {"#s1 + div", "d2"},
+        {"#s1 ~ div p", "p2"},
+        {"[lang|=en]", "a b"},
+        {"[class~=x]", "a c"},
+        {"span[class~=y], #p3", "a p3"},
+    };
+
+    int failures = 0;
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+        failures += check_selector(ctx, cases[i][0], cases[i][1]);
+
+    static const char *const unsupported[] = {":first-child", "p:first-child", "a::before", "div >", "> p",
+                                              "[lang", "[lang=en", "p, ", "#", "div..box", "p:not(.x)"};
+    for (size_t i = 0; i < sizeof(unsupported) / sizeof(unsupported[0]); i++)
+    {
+        html_selector *selector = html_selector_compile(unsupported[i]);
+        if (selector || html_get_error_code() != HTML_ERROR_INVALID_ARGUMENT)
+        {
+            printf("FAIL selector \"%s\" is not rejected\n", unsupported[i]);
+            failures++;
+        }
+        html_selector_free(selector);
+    }
+    if (!failures)
+        printf("ok   unsupported selectors are rejected\n");
+
+    html_finalize(ctx);
+    return failures;
+}
+
+static void add_card(html_context *ctx, html_element *parent, const char *suffix, const char *title,
+                     const char *href)
+{
+    char attributes[64];
+    snprintf(attributes, sizeof(attributes), "id='card%s' class='card'", suffix);
+    html_element *card = add(ctx, parent, "div", attributes, NULL);
+    snprintf(attributes, sizeof(attributes), "id='title%s'", suffix);
+    add(ctx, card, "h2", attributes, title);
+    add(ctx, card, "p", "class='body'", "Body");
+    snprintf(attributes, sizeof(attributes), "id='link%s' href='%s'", suffix, href);
+    add(ctx, card, "a", attributes, "More");
+}
+
+// the same edits on instantiated cards and on cards built element by element
+static void edit_cards(html_context *ctx)
+{
+    html_set_element_content(html_get_element_by_id(ctx, "title-1"), "Edited");
+    html_set_element_attribute(html_get_element_by_id(ctx, "link-1"), "href", "/one");
+    add(ctx, html_get_element_by_id(ctx, "card-1"), "p", "class='note'", "Added");
+    html_add_class(html_get_element_by_id(ctx, "card-3"), "wide");
+    html_free_element(html_get_element_by_id(ctx, "title-3"));
+    html_free_element(html_get_element_by_id(ctx, "card-4"));
+}
+
+static int test_fragments(void)
+{
+    html_context *scratch = html_init_string("Fragment Test");
+    if (!scratch)
+        return check_equal("fragments", NULL, 0, NULL, 0);
+    add_card(scratch, scratch->current, "", "Title", "/item");
+    html_fragment *card = html_fragment_create(html_get_element_by_id(scratch, "card"));
+    html_finalize(scratch);
+    if (!card)
+        return check_equal("fragments", NULL, 0, NULL, 0);
+
+    static const char *const expected_ids[] = {"card-1", "title-1", "link-1", "card-3", "link-3", "card-x",
+                                               "title-x", "link-x"};
+    static const char *const removed_ids[] = {"title-3", "card-4", "title-4", "link-4"};
+    int failures = 0;
+
+    for (int arena = 0; arena < 2; arena++)
+    {
+        int flags = arena ? HTML_CONTEXT_ARENA : 0;
+        html_context *ctx = html_init_string_ex("Fragment Test", flags);
+        html_context *plain = html_init_string_ex("Fragment Test", flags);
+        if (!ctx || !plain)
+        {
+            html_finalize(ctx);
+            html_finalize(plain);
+            failures += check_equal("fragments", NULL, 0, NULL, 0);
+            continue;
+        }
+
+        // card-2 is taken, so the second copy gets the next free number
+        add(ctx, ctx->current, "p", "id='card-2'", "taken");
+        add(plain, plain->current, "p", "id='card-2'", "taken");
+
+        const char *roots[4] = {NULL, NULL, NULL, NULL};
+        for (int i = 0; i < 3; i++)
+        {
+            html_element *root = html_fragment_instantiate(ctx, ctx->current, card, NULL);
+            roots[i] = root ? root->id : NULL;
+        }
+        html_fragment_override items[] = {{"title", NULL, "Custom"}, {"link", "href", "/custom"}};
+        html_fragment_overrides overrides = {"-x", items, 2};
+        html_element *custom = html_fragment_instantiate(ctx, ctx->current, card, &overrides);
+        roots[3] = custom ? custom->id : NULL;
+
+        add_card(plain, plain->current, "-1", "Title", "/item");
+        add_card(plain, plain->current, "-3", "Title", "/item");
+        add_card(plain, plain->current, "-4", "Title", "/item");
+        add_card(plain, plain->current, "-x", "Custom", "/custom");
+
+        char name[64];
+        snprintf(name, sizeof(name), "fragment IDs, %s", arena ? "arena" : "malloc");
+        char found[64];
+        snprintf(found, sizeof(found), "%s %s %s %s", roots[0] ? roots[0] : "-", roots[1] ? roots[1] : "-",
+                 roots[2] ? roots[2] : "-", roots[3] ? roots[3] : "-");
+        failures += check_equal(name, "card-1 card-3 card-4 card-x", 27, found, strlen(found));
+
+        edit_cards(ctx);
+        edit_cards(plain);
+
+        for (size_t i = 0; i < sizeof(expected_ids) / sizeof(expected_ids[0]); i++)
+        {
+            if (!html_get_element_by_id(ctx, expected_ids[i]))
+            {
+                printf("FAIL fragment %s: %s is not indexed\n", arena ? "arena" : "malloc", expected_ids[i]);
+                failures++;
+            }
+        }
+        for (size_t i = 0; i < sizeof(removed_ids) / sizeof(removed_ids[0]); i++)
+        {
+            if (html_get_element_by_id(ctx, removed_ids[i]))
+            {
+                printf("FAIL fragment %s: %s is still indexed\n", arena ? "arena" : "malloc", removed_ids[i]);
+                failures++;
+            }
+        }
+
+        snprintf(name, sizeof(name), "edited fragment copies, %s", arena ? "arena" : "malloc");
+        failures += check_strings(name, html_render_to_string(plain), html_render_to_string(ctx));
+        html_finalize(ctx);
+        html_finalize(plain);
+    }
+
+    html_fragment_free(card);
+    return failures;
+}
+
+static html_element *batch_page(html_context *ctx, int batched)
+{
+    static const char *const options[] = {"Red", NULL, "Green & <Blue>", "Cyan", "Magenta", "Yellow"};
+    static const char *const items[] = {"one", "two", NULL};
+    const char *attributes = "class='opt' data-kind=\"color\" disabled";
+    int n = (int)(sizeof(options) / sizeof(options[0]));
+
+    html_element *select = add(ctx, ctx->current, "select", "name='color'", NULL);
+    if (batched)
+        html_add_children_batch(ctx, select, HTML_TAG_OPTION, options, n, attributes);
+    else
+        for (int i = 0; i < n; i++)
+            html_add_child_tag(ctx, select, HTML_TAG_OPTION, attributes, options[i]);
+
+    html_begin_unordered_list(ctx, NULL);
+    if (batched)
+        html_add_list_items(ctx, items, 3, "class='item'");
+    else
+        for (int i = 0; i < 3; i++)
+            html_add_list_item(ctx, items[i], "class='item'");
+    html_end_list(ctx);
+
+    // every element got its own copy of the attributes
+    html_add_class(select->children[0], "first");
+    html_set_element_attribute(select->children[2], "data-kind", "mixed");
+    html_free_element(select->children[3]);
+    return select;
+}
+
+static int test_children_batch(void)
+{
+    int failures = 0;
+
+    for (int arena = 0; arena < 2; arena++)
+    {
+        int flags = arena ? HTML_CONTEXT_ARENA : 0;
+        html_context *single = html_init_string_ex("Batch Test", flags);
+        html_context *batch = html_init_string_ex("Batch Test", flags);
+        html_element *select = batch ? batch_page(batch, 1) : NULL;
+        if (single)
+            batch_page(single, 0);
+
+        char name[64];
+        snprintf(name, sizeof(name), "batch children match single adds, %s", arena ? "arena" : "malloc");
+        failures += check_strings(name, single ? html_render_to_string(single) : NULL,
+                                  batch ? html_render_to_string(batch) : NULL);
+
+        // an ID in the shared attributes would repeat on every element
+        if (select)
+        {
+            static const char *const contents[] = {"a", "b"};
+            int before = select->children_count;
+            int result = html_add_children_batch(batch, select, HTML_TAG_OPTION, contents, 2, "class='x' id='dup'");
+            if (result != -1 || html_get_error_code() != HTML_ERROR_INVALID_ARGUMENT ||
+                select->children_count != before || html_get_element_by_id(batch, "dup"))
+            {
+                printf("FAIL batch with an ID, %s: not rejected\n", arena ? "arena" : "malloc");
+                failures++;
+            }
+            else
+            {
+                printf("ok   batch with an ID is rejected, %s\n", arena ? "arena" : "malloc");
+            }
+        }
+
+        html_finalize(single);
+        html_finalize(batch);
+    }
+    return failures;
+}
+
+int main()
+{
+    int failures = 0;
+    failures += test_streaming();
+    failures += test_chunks();
+    failures += test_fd();
+    failures += test_parallel();
+    failures += test_render_cache();
+    failures += test_number_format();
+    failures += test_bulk_tables();
+    failures += test_template();
+    failures += test_diff();
+    failures += test_escape();
+    failures += test_selectors();
+    failures += test_fragments();
+    failures += test_children_batch();
+
+    if (failures)
+    {
+        printf("%d render test(s) failed\n", failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,205 @@
+#include "HTML.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HTML_ARENA_ALIGN 16
+#define HTML_ARENA_MAX_BLOCK (1024 * 1024)
+
+static size_t html_arena_align(size_t size)
+{
+    return (size + HTML_ARENA_ALIGN - 1) & ~(size_t)(HTML_ARENA_ALIGN - 1);
+}
+
+static html_arena_block *html_arena_new_block(size_t size)
+{
+    size_t header = html_arena_align(sizeof(html_arena_block));
+    html_arena_block *block = (html_arena_block *)malloc(header + size);
+    if (!block)
+    {
+        html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for arena block");
+        return NULL;
+    }
+
+    block->data = (char *)block + header;
+    block->next = NULL;
+    block->size = size;
+    block->used = 0;
+    return block;
+}
+
+html_arena *html_arena_create(size_t block_size)
+{
+    html_arena *arena = (html_arena *)malloc(sizeof(html_arena));
+    if (!arena)
+    {
+        html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for arena");
+        return NULL;
+    }
+
+    if (block_size < 1024)
+        block_size = 1024;
+
+    arena->head = NULL;
+    arena->spare = NULL;
+    arena->block_size = html_arena_align(block_size);
+    arena->last = NULL;
+    return arena;
+}
+
+// blocks kept by html_arena_reset are handed out before new ones are made
+static html_arena_block *html_arena_take_spare(html_arena *arena, size_t size)
+{
+    html_arena_block **link = &arena->spare;
+    while (*link && (*link)->size < size)
+        link = &(*link)->next;
+
+    html_arena_block *block = *link;
+    if (block)
+    {
+        *link = block->next;
+        block->next = NULL;
+        block->used = 0;
+    }
+    return block;
+}
+
+void *html_arena_alloc(html_arena *arena, size_t size)
+{
+    if (!arena)
+        return NULL;
+
+    size = html_arena_align(size ? size : 1);
+
+    html_arena_block *block = arena->head;
+    if (block && block->size - block->used >= size)
+    {
+        void *ptr = block->data + block->used;
+        block->used += size;
+        arena->last = ptr;
+        return ptr;
+    }
+
+    // oversized requests get a dedicated block so the current one keeps serving small ones
+    if (size > arena->block_size / 4)
+    {
+        html_arena_block *big = html_arena_take_spare(arena, size);
+        if (!big)
+            big = html_arena_new_block(size);
+        if (!big)
+            return NULL;
+
+        big->used = size;
+        if (block)
+        {
+            big->next = block->next;
+            block->next = big;
+        }
+        else
+        {
+            arena->head = big;
+        }
+        return big->data;
+    }
+
+    html_arena_block *fresh = html_arena_take_spare(arena, size);
+    if (!fresh)
+    {
+        fresh = html_arena_new_block(arena->block_size);
+        if (!fresh)
+            return NULL;
+
+        if (arena->block_size < HTML_ARENA_MAX_BLOCK)
+            arena->block_size *= 2;
+    }
+
+    fresh->next = arena->head;
+    arena->head = fresh;
+
+    fresh->used = size;
+    arena->last = fresh->data;
+    return fresh->data;
+}
+
+void *html_arena_realloc(html_arena *arena, void *ptr, size_t old_size, size_t new_size)
+{
+    if (!arena)
+        return NULL;
+
+    if (!ptr)
+        return html_arena_alloc(arena, new_size);
+
+    // the most recent allocation can grow in place
+    html_arena_block *block = arena->head;
+    if (ptr == arena->last && block)
+    {
+        size_t offset = (size_t)((char *)ptr - block->data);
+        size_t aligned = html_arena_align(new_size);
+        if (offset + aligned <= block->size)
+        {
+            block->used = offset + aligned;
+            return ptr;
+        }
+    }
+
+    void *fresh = html_arena_alloc(arena, new_size);
+    if (!fresh)
+        return NULL;
+
+    memcpy(fresh, ptr, old_size < new_size ? old_size : new_size);
+    return fresh;
+}
+
+char *html_arena_strdup(html_arena *arena, const char *str)
+{
+    if (!arena || !str)
+        return NULL;
+
+    size_t len = strlen(str);
+    char *copy = (char *)html_arena_alloc(arena, len + 1);
+    if (!copy)
+        return NULL;
+
+    memcpy(copy, str, len + 1);
+    return copy;
+}
+
+void html_arena_reset(html_arena *arena)
+{
+    if (!arena)
+        return;
+
+    // every block becomes spare; nothing goes back to the allocator
+    html_arena_block *block = arena->head;
+    while (block)
+    {
+        html_arena_block *next = block->next;
+        block->next = arena->spare;
+        arena->spare = block;
+        block = next;
+    }
+
+    arena->head = NULL;
+    arena->last = NULL;
+}
+
+static void html_arena_free_blocks(html_arena_block *block)
+{
+    while (block)
+    {
+        html_arena_block *next = block->next;
+        free(block);
+        block = next;
+    }
+}
+
+void html_arena_destroy(html_arena *arena)
+{
+    if (!arena)
+        return;
+
+    html_arena_free_blocks(arena->head);
+    html_arena_free_blocks(arena->spare);
+
+    free(arena);
+}
@@ -0,0 +1,491 @@
+#include "HTML.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+// attribute names are interned once per process and shared by every element
+static html_name_table attribute_names = {0};
+
+typedef struct
+{
+    const char *name;
+    size_t name_len;
+    const char *value;
+    size_t value_len;
+    char quote;
+    int has_value;
+} html_attribute_token;
+
+const char *html_intern_attribute_name(const char *name, size_t len)
+{
+    if (!name || len == 0)
+        return NULL;
+
+    const char *interned = NULL;
+    html_name_table_intern_shared(&attribute_names, name, len, &interned);
+    return interned;
+}
+
+static int html_is_id_attribute(const char *name)
+{
+    return name[0] == 'i' && name[1] == 'd' && name[2] == '\0';
+}
+
+static const char *html_next_attribute(const char *cursor, html_attribute_token *token)
+{
+    while (isspace((unsigned char)*cursor))
+        cursor++;
+
+    if (!*cursor)
+        return NULL;
+
+    memset(token, 0, sizeof(*token));
+    token->name = cursor;
+    while (*cursor && *cursor != '=' && !isspace((unsigned char)*cursor))
+        cursor++;
+    token->name_len = cursor - token->name;
+
+    const char *after_name = cursor;
+    while (isspace((unsigned char)*cursor))
+        cursor++;
+
+    if (*cursor != '=' || token->name_len == 0)
+    {
+        // a bare name such as "hidden", or a stray '=' that we skip over
+        if (token->name_len == 0)
+            cursor++;
+        else
+            cursor = after_name;
+        return cursor;
+    }
+
+    cursor++;
+    while (isspace((unsigned char)*cursor))
+        cursor++;
+
+    token->has_value = 1;
+    if (*cursor == '"' || *cursor == '\'')
+    {
+        token->quote = *cursor++;
+        token->value = cursor;
+        while (*cursor && *cursor != token->quote)
+            cursor++;
+        token->value_len = cursor - token->value;
+        if (*cursor)
+            cursor++;
+    }
+    else
+    {
+        token->value = cursor;
+        while (*cursor && !isspace((unsigned char)*cursor))
+            cursor++;
+        token->value_len = cursor - token->value;
+    }
+
+    return cursor;
+}
+
+int html_parse_attributes(html_element *element, const char *attributes)
+{
+    if (!element || !attributes)
+        return 0;
+
+    html_attribute_token token;
+    const char *cursor = attributes;
+    int count = 0;
+    size_t value_bytes = 0;
+
+    while ((cursor = html_next_attribute(cursor, &token)) != NULL)
+    {
+        if (token.name_len == 0)
+            continue;
+        count++;
+        if (token.has_value)
+            value_bytes += token.value_len + 1;
+    }
+
+    if (count == 0)
+        return 0;
+
+    // one block holds the attribute array followed by every value string
+    char *block = (char *)html_element_alloc(element, count * sizeof(html_attribute) + value_bytes,
+                                             HTML_ELEMENT_OWNS_ATTRIBUTE_DATA);
+    if (!block)
+        return -1;
+
+    element->attribute_data = block;
+
+    html_attribute *attrs = (html_attribute *)block;
+    char *values = block + count * sizeof(html_attribute);
+    int index = 0;
+
+    cursor = attributes;
+    while ((cursor = html_next_attribute(cursor, &token)) != NULL)
+    {
+        if (token.name_len == 0)
+            continue;
+
+        html_attribute *attr = &attrs[index];
+        memset(attr, 0, sizeof(*attr));
+        attr->name = html_intern_attribute_name(token.name, token.name_len);
+        if (!attr->name)
+        {
+            element->id = NULL;
+            return -1;
+        }
+
+        if (token.has_value)
+        {
+            memcpy(values, token.value, token.value_len);
+            values[token.value_len] = '\0';
+            attr->value = values;
+            attr->length = (unsigned int)token.value_len;
+            attr->capacity = (unsigned int)token.value_len;
+            attr->quote = (unsigned char)token.quote;
+            values += token.value_len + 1;
+
+            if (!element->id && html_is_id_attribute(attr->name))
+                element->id = attr->value;
+        }
+
+        index++;
+    }
+
+    element->attributes = attrs;
+    element->attribute_count = count;
+    element->attribute_capacity = count;
+    return 0;
+}
+
+html_attribute *html_find_attribute(const html_element *element, const char *name)
+{
+    if (!element || !name)
+        return NULL;
+
+    for (int i = 0; i < element->attribute_count; i++)
+    {
+        if (strcmp(element->attributes[i].name, name) == 0)
+            return &element->attributes[i];
+    }
+
+    return NULL;
+}
+
+const char *html_get_element_attribute(const html_element *element, const char *name)
+{
+    html_attribute *attr = html_find_attribute(element, name);
+    if (!attr)
+        return NULL;
+
+    return attr->value ? attr->value : "";
+}
+
+static int html_attribute_reserve(html_element *element, html_attribute *attr, size_t length)
+{
+    if (attr->value && length <= attr->capacity)
+        return 0;
+
+    size_t capacity = length < 15 ? 15 : length + length / 2;
+    char *fresh;
+    int owned = 0;
+    if (html_element_in_arena(element))
+    {
+        fresh = (char *)html_arena_alloc(element->owner->arena, capacity + 1);
+    }
+    else
+    {
+        fresh = (char *)malloc(capacity + 1);
+        owned = 1;
+    }
+
+    if (!fresh)
+    {
+        html_set_error_code(HTML_ERROR_MEMORY, "Memory allocation failed for attribute value");
+        return -1;
+    }
+
+    if (attr->value)
+        memcpy(fresh, attr->value, attr->length + 1);
+    else
+        fresh[0] = '\0';
+
+    if (element->id && element->id == attr->value)
+        element->id = fresh;
+
+    if (attr->flags & HTML_ATTRIBUTE_OWNS_VALUE)
+        free(attr->value);
+
+    attr->value = fresh;
+    attr->capacity = (unsigned int)capacity;
+    attr->flags = owned ? (attr->flags | HTML_ATTRIBUTE_OWNS_VALUE) : (attr->flags & ~HTML_ATTRIBUTE_OWNS_VALUE);
+    return 0;
+}
+
+static html_attribute *html_append_attribute(html_element *element, const char *name)
+{
+    const char *interned = html_intern_attribute_name(name, strlen(name));
+    if (!interned)
+        return NULL;
+
+    if (element->attribute_count >= element->attribute_capacity)
+    {
+        int new_capacity = element->attribute_capacity ? element->attribute_capacity * 2 : 4;
+        html_attribute *old = element->attributes;
+        int owned = element->flags & HTML_ELEMENT_OWNS_ATTRIBUTES;
+
+        html_attribute *grown = (html_attribute *)html_element_alloc(element, new_capacity * sizeof(html_attribute),
+                                                                     HTML_ELEMENT_OWNS_ATTRIBUTES);
+        if (!grown)
+        {
+            if (owned)
+                element->flags |= HTML_ELEMENT_OWNS_ATTRIBUTES;
+            return NULL;
+        }
+
+        if (element->attribute_count)
+            memcpy(grown, old, element->attribute_count * sizeof(html_attribute));
+        if (owned)
+            free(old);
+
+        element->attributes = grown;
+        element->attribute_capacity = new_capacity;
+    }
+
+    html_attribute *attr = &element->attributes[element->attribute_count++];
+    memset(attr, 0, sizeof(*attr));
+    attr->name = interned;
+    return attr;
+}
+
+static void html_reindex_element_id(html_element *element)
+{
+    // only elements attached to a document live in its ID index
+    if (element->owner && element->parent && element->id)
+        html_register_element_by_id(element->owner, element);
+}
+
+static int html_store_attribute(html_element *element, const char *name, const char *value)
+{
+    html_attribute *attr = html_find_attribute(element, name);
+    if (!attr)
+    {
+        attr = html_append_attribute(element, name);
+        if (!attr)
+            return -1;
+    }
+
+    size_t length = strlen(value);
+    char *copy = NULL;
+    if (attr->value && value >= attr->value && value <= attr->value + attr->capacity && length > attr->capacity)
+    {
+        // value points into the buffer that is about to be replaced
+        copy = html_strdup(value);
+        if (!copy)
+            return -1;
+        value = copy;
+    }
+
+    if (html_attribute_reserve(element, attr, length) != 0)
+    {
+        free(copy);
+        return -1;
+    }
+
+    memmove(attr->value, value, length + 1);
+    free(copy);
+
+    attr->length = (unsigned int)length;
+    if (!attr->quote || strchr(attr->value, attr->quote))
+        attr->quote = strchr(attr->value, '"') ? '\'' : '"';
+
+    if (html_is_id_attribute(attr->name))
+        element->id = attr->value;
+
+    return 0;
+}
+
+int html_set_element_attribute(html_element *element, const char *name, const char *value)
+{
+    if (!element || !name || !value)
+        return -1;
+
+    html_mark_dirty(element);
+
+    if (html_is_id_attribute(name))
+    {
+        html_unregister_element_by_id(element->owner, element);
+        int result = html_store_attribute(element, name, value);
+        html_reindex_element_id(element);
+        return result;
+    }
+
+    if (strcmp(name, "class") == 0)
+    {
+        html_unindex_classes(element->owner, element);
+        int result = html_store_attribute(element, name, value);
+        html_index_classes(element->owner, element);
+        return result;
+    }
+
+    return html_store_attribute(element, name, value);
+}
+
+int html_remove_element_attribute(html_element *element, const char *name)
+{
+    html_attribute *attr = html_find_attribute(element, name);
+    if (!attr)
+        return -1;
+
+    html_mark_dirty(element);
+
+    int is_id = element->id && element->id == attr->value;
+    if (is_id)
+        html_unregister_element_by_id(element->owner, element);
+
+    int is_class = strcmp(attr->name, "class") == 0;
+    if (is_class)
+        html_unindex_classes(element->owner, element);
+
+    if (element->id && element->id == attr->value)
+        element->id = NULL;
+
+    if (attr->flags & HTML_ATTRIBUTE_OWNS_VALUE)
+        free(attr->value);
+
+    int index = (int)(attr - element->attributes);
+    memmove(attr, attr + 1, (element->attribute_count - index - 1) * sizeof(html_attribute));
+    element->attribute_count--;
+
+    if (is_id)
+    {
+        html_attribute *id = html_find_attribute(element, "id");
+        if (id)
+            element->id = id->value;
+        html_reindex_element_id(element);
+    }
+
+    if (is_class)
+        html_index_classes(element->owner, element);
+
+    return 0;
+}
+
+static const char *html_find_class_token(const char *classes, const char *classname, size_t len)
+{
+    const char *cursor = classes;
+    while (*cursor)
+    {
+        while (isspace((unsigned char)*cursor))
+            cursor++;
+
+        const char *start = cursor;
+        while (*cursor && !isspace((unsigned char)*cursor))
+            cursor++;
+
+        if ((size_t)(cursor - start) == len && len > 0 && memcmp(start, classname, len) == 0)
+            return start;
+    }
+
+    return NULL;
+}
+
+int html_has_class(const html_element *element, const char *classname)
+{
+    if (!element || !classname)
+        return 0;
+
+    html_attribute *attr = html_find_attribute(element, "class");
+    if (!attr || !attr->value)
+        return 0;
+
+    return html_find_class_token(attr->value, classname, strlen(classname)) != NULL;
+}
+
+int html_add_class(html_element *element, const char *classname)
+{
+    if (!element || !classname)
+        return -1;
+
+    size_t class_len = strlen(classname);
+    html_attribute *attr = html_find_attribute(element, "class");
+    if (!attr || !attr->value)
+        return html_set_element_attribute(element, "class", classname);
+
+    if (html_find_class_token(attr->value, classname, class_len))
+        return 0;
+
+    size_t length = attr->length;
+    size_t new_length = length + (length ? 1 : 0) + class_len;
+    if (html_attribute_reserve(element, attr, new_length) != 0)
+        return -1;
+
+    html_mark_dirty(element);
+
+    if (length)
+        attr->value[length++] = ' ';
+    memcpy(attr->value + length, classname, class_len + 1);
+    attr->length = (unsigned int)new_length;
+
+    if (element->flags & HTML_ELEMENT_INDEXED)
+        html_index_class(element->owner, element, classname, class_len);
+
+    return 0;
+}
+
+int html_remove_class(html_element *element, const char *classname)
+{
+    if (!element || !classname)
+        return -1;
+
+    html_attribute *attr = html_find_attribute(element, "class");
+    if (!attr || !attr->value)
+        return -1;
+
+    size_t class_len = strlen(classname);
+    char *start = (char *)html_find_class_token(attr->value, classname, class_len);
+    if (!start)
+        return -1;
+
+    html_mark_dirty(element);
+
+    if (element->flags & HTML_ELEMENT_INDEXED)
+        html_unindex_class(element->owner, element, classname, class_len);
+
+    // a class listed more than once is gone only when every copy is
+    do
+    {
+        char *end = start + class_len;
+        while (isspace((unsigned char)*end))
+            end++;
+        if (!*end)
+        {
+            // last token, drop the separator in front of it instead
+            while (start > attr->value && isspace((unsigned char)start[-1]))
+                start--;
+        }
+
+        memmove(start, end, strlen(end) + 1);
+        start = (char *)html_find_class_token(attr->value, classname, class_len);
+    } while (start);
+
+    attr->length = (unsigned int)strlen(attr->value);
+    return 0;
+}
+
+void html_free_attributes(html_element *element)
+{
+    for (int i = 0; i < element->attribute_count; i++)
+    {
+        if (element->attributes[i].flags & HTML_ATTRIBUTE_OWNS_VALUE)
+            free(element->attributes[i].value);
+    }
+
+    html_element_release(element, element->attributes, HTML_ELEMENT_OWNS_ATTRIBUTES);
+    html_element_release(element, element->attribute_data, HTML_ELEMENT_OWNS_ATTRIBUTE_DATA);
+    element->attributes = NULL;
+    element->attribute_data = NULL;
+    element->attribute_count = 0;
+    element->attribute_capacity = 0;
+    element->id = NULL;
+}
@@ -0,0 +1,509 @@
+#include "HTML.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+#define HTML_BULK_NONE ((size_t)-1)
+
+//////////number formatting///////
+
+static const char html_digit_pairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static int html_format_unsigned(char *buf, unsigned long long value)
+{
+    char digits[24];
+    char *end = digits + sizeof(digits);
+    char *p = end;
+
+    // two digits per division
+    while (value >= 100)
+    {
+        unsigned int pair = (unsigned int)(value % 100) * 2;
+        value /= 100;
+        *--p = html_digit_pairs[pair + 1];
+        *--p = html_digit_pairs[pair];
+    }
+
+    if (value >= 10)
+    {
+        *--p = html_digit_pairs[value * 2 + 1];
+        *--p = html_digit_pairs[value * 2];
+    }
+    else
+    {
+        *--p = (char)('0' + value);
+    }
+
+    int len = (int)(end - p);
+    memcpy(buf, p, len);
+    buf[len] = '\0';
+    return len;
+}
+
+int html_format_int(char *buf, long long value)
+{
+    if (value < 0)
+    {
+        buf[0] = '-';
+        return 1 + html_format_unsigned(buf + 1, 0ULL - (unsigned long long)value);
+    }
+    return html_format_unsigned(buf, (unsigned long long)value);
+}
+
+int html_format_double(char *buf, double value, int precision)
+{
+    static const double scales[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9};
+
+    if (!isfinite(value))
+        return snprintf(buf, HTML_NUMBER_BUFFER_SIZE, "%.17g", value);
+
+    if (precision < 0)
+        precision = 0;
+    if (precision > HTML_NUMBER_MAX_PRECISION)
+        precision = HTML_NUMBER_MAX_PRECISION;
+
+    // fixed notation through integer arithmetic while the scaled value fits
+    // the integer digits exactly
+    if (precision <= 9 && fabs(value) < 1e15 / scales[precision])
+    {
+        double scaled = fabs(value) * scales[precision];
+        unsigned long long magnitude = (unsigned long long)scaled;
+        double fraction = scaled - (double)magnitude;
+
+        // the product may be off by half an ulp, so a fraction that close to
+        // one half could round either way and is left to printf
+        if (fabs(fraction - 0.5) > scaled * DBL_EPSILON)
+        {
+            if (fraction > 0.5)
+                magnitude++;
+
+            unsigned long long scale = (unsigned long long)scales[precision];
+            int len = 0;
+            if (signbit(value))
+                buf[len++] = '-';
+            len += html_format_unsigned(buf + len, magnitude / scale);
+
+            if (precision > 0)
+            {
+                char digits[16];
+                int count = html_format_unsigned(digits, magnitude % scale);
+                buf[len++] = '.';
+                memset(buf + len, '0', precision - count);
+                memcpy(buf + len + precision - count, digits, count + 1);
+                len += precision;
+            }
+            return len;
+        }
+    }
+
+    return snprintf(buf, HTML_NUMBER_BUFFER_SIZE, "%.*f", precision, value);
+}
+
+//////////bulk tables///////
+
+typedef struct html_table_source html_table_source;
+
+// appends the text of one cell to the pool; returns 1 when the cell has
+// content, 0 when it is empty
+typedef int (*html_table_emit_fn)(const html_table_source *source, int row, int column, html_writer *pool);
+
+struct html_table_source
+{
+    html_table_emit_fn emit;
+    const char *const *header;
+    const char *const *const *rows;
+    html_table_cell_fn cell;
+    void *user;
+    const html_table_column *columns;
+};
+
+static int html_emit_text(html_writer *pool, const char *text)
+{
+    if (!text)
+        return 0;
+
+    html_writer_append(pool, text, strlen(text));
+    return 1;
+}
+
+static int html_emit_header(const html_table_source *source, int column, html_writer *pool)
+{
+    if (source->columns)
+        return html_emit_text(pool, source->columns[column].header);
+    return html_emit_text(pool, source->header[column]);
+}
+
+static int html_emit_rows(const html_table_source *source, int row, int column, html_writer *pool)
+{
+    if (row < 0)
+        return html_emit_header(source, column, pool);
+    return html_emit_text(pool, source->rows[row][column]);
+}
+
+static int html_emit_callback(const html_table_source *source, int row, int column, html_writer *pool)
+{
+    if (row < 0)
+        return html_emit_header(source, column, pool);
+    return html_emit_text(pool, source->cell(source->user, row, column));
+}
+
+static int html_emit_column(const html_table_source *source, int row, int column, html_writer *pool)
+{
+    if (row < 0)
+        return html_emit_header(source, column, pool);
+
+    const html_table_column *col = &source->columns[column];
+    char number[HTML_NUMBER_BUFFER_SIZE];
+
+    switch (col->type)
+    {
+    case HTML_COLUMN_INT:
+        html_writer_append(pool, number, html_format_int(number, ((const long long *)col->values)[row]));
+        return 1;
+    case HTML_COLUMN_DOUBLE:
+        html_writer_append(pool, number, html_format_double(number, ((const double *)col->values)[row], col->precision));
+        return 1;
+    default:
+        return html_emit_text(pool, ((const char *const *)col->values)[row]);
+    }
+}
+
+// each element is cleared right before it is filled, so the block is
+// written in a single pass
+static void html_bulk_element_init(html_element *element, html_context *ctx, int tag, const char *tagname,
+                                   html_element *parent)
+{
+    memset(element, 0, sizeof(html_element));
+    element->owner = ctx;
+    element->flags = HTML_ELEMENT_DIRTY;
+    element->tag = tag;
+    element->tagname = tagname;
+    element->parent = parent;
+}
+
+static int html_build_table(html_context *ctx, const char *attributes, int nrows, int ncols, int header,
+                            const html_table_source *source)
+{
+    if (!ctx || !ctx->current || nrows < 0 || ncols <= 0)
+        return -1;
+
+    // the structure is fixed, so the parent is the only thing left to check
+    if (!html_tag_is_valid_child(ctx->current->tag, HTML_TAG_TABLE))
+    {
+        html_set_error_tags(HTML_ERROR_INVALID_CHILD, "Invalid child tag '%s' for parent '%s'", HTML_TAG_TABLE,
+                            ctx->current->tag);
+        return -1;
+    }
+
+    int rows = nrows + (header ? 1 : 0);
+    size_t cells = (size_t)rows * ncols;
+
+    // cell text is gathered first so the tree can be one exactly sized block
+    size_t *offsets = (size_t *)malloc((cells ? cells : 1) * sizeof(size_t));
+    html_writer pool;
+    if (!offsets || !html_writer_init(&pool, cells * 8, NULL, NULL))
+    {
+        free(offsets);
+        html_set_error_code(HTML_ERROR_MEMORY, "Memory allocation failed for table");
+        return -1;
+    }
+
+    size_t k = 0;
+    for (int r = header ? -1 : 0; r < nrows; r++)
+    {
+        for (int c = 0; c < ncols; c++)
+        {
+            size_t start = pool.length;
+            offsets[k++] = source->emit(source, r, c, &pool) ? start : HTML_BULK_NONE;
+            if (offsets[k - 1] != HTML_BULK_NONE)
+                html_writer_putc(&pool, '\0');
+        }
+    }
+
+    if (pool.error)
+    {
+        free(offsets);
+        html_writer_free(&pool);
+        return -1;
+    }
+
+    size_t nodes = 1 + rows + cells;
+    size_t element_bytes = nodes * sizeof(html_element);
+    size_t children_bytes = (rows + cells) * sizeof(html_element *);
+    size_t size = element_bytes + children_bytes + pool.length;
+
+    int in_arena = (ctx->flags & HTML_CONTEXT_ARENA) && ctx->arena;
+    char *block = in_arena ? (char *)html_arena_alloc(ctx->arena, size) : (char *)malloc(size);
+    if (!block)
+    {
+        free(offsets);
+        html_writer_free(&pool);
+        html_set_error_code(HTML_ERROR_MEMORY, "Memory allocation failed for table");
+        return -1;
+    }
+
+    html_element *elements = (html_element *)block;
+    html_element **children = (html_element **)(block + element_bytes);
+    char *strings = block + element_bytes + children_bytes;
+    memcpy(strings, pool.data, pool.length);
+    html_writer_free(&pool);
+
+    // the table carries the block, so freeing it releases every row and cell
+    html_element *table = &elements[0];
+    html_bulk_element_init(table, ctx, HTML_TAG_TABLE, html_tag_name(HTML_TAG_TABLE), ctx->current);
+    table->children = children;
+    table->children_count = rows;
+    table->children_capacity = rows;
+    if (!in_arena)
+        table->flags |= HTML_ELEMENT_OWNS_SELF;
+
+    html_element *row_elements = elements + 1;
+    html_element *cell_elements = elements + 1 + rows;
+    html_element **cell_slots = children + rows;
+    const char *tr_name = html_tag_name(HTML_TAG_TR);
+
+    for (int r = 0; r < rows; r++)
+    {
+        html_element *tr = &row_elements[r];
+        int tag = header && r == 0 ? HTML_TAG_TH : HTML_TAG_TD;
+        const char *tagname = html_tag_name(tag);
+
+        children[r] = tr;
+        html_bulk_element_init(tr, ctx, HTML_TAG_TR, tr_name, table);
+        tr->children = cell_slots + (size_t)r * ncols;
+        tr->children_count = ncols;
+        tr->children_capacity = ncols;
+
+        for (int c = 0; c < ncols; c++)
+        {
+            size_t index = (size_t)r * ncols + c;
+            html_element *cell = &cell_elements[index];
+
+            tr->children[c] = cell;
+            html_bulk_element_init(cell, ctx, tag, tagname, tr);
+            if (offsets[index] != HTML_BULK_NONE)
+                cell->content = strings + offsets[index];
+        }
+    }
+    free(offsets);
+
+    if (attributes && html_parse_attributes(table, attributes) != 0)
+    {
+        html_free_attributes(table);
+        if (!in_arena)
+            free(block);
+        return -1;
+    }
+
+    if (!html_element_reserve_children(ctx->current, ctx->current->children_count + 1))
+    {
+        html_free_attributes(table);
+        if (!in_arena)
+            free(block);
+        return -1;
+    }
+
+    ctx->current->children[ctx->current->children_count++] = table;
+    html_mark_dirty(ctx->current);
+
+    if (table->id)
+        html_register_element_by_id(ctx, table);
+    for (size_t i = 0; i < nodes; i++)
+        html_index_element(ctx, &elements[i]);
+
+    // the table is complete, so a streaming context can write it out right away
+    return html_stream_element(ctx, table) ? 0 : -1;
+}
+
+int html_add_table_bulk(html_context *ctx, const char *attributes, int nrows, int ncols,
+                        const char *const *const *data, const char *const *header)
+{
+    if (!data && nrows > 0)
+        return -1;
+
+    html_table_source source = {html_emit_rows, header, data, NULL, NULL, NULL};
+    return html_build_table(ctx, attributes, nrows, ncols, header != NULL, &source);
+}
+
+int html_add_table_bulk_cb(html_context *ctx, const char *attributes, int nrows, int ncols,
+                           html_table_cell_fn cell, void *user, const char *const *header)
+{
+    if (!cell)
+        return -1;
+
+    html_table_source source = {html_emit_callback, header, NULL, cell, user, NULL};
+    return html_build_table(ctx, attributes, nrows, ncols, header != NULL, &source);
+}
+
+int html_add_table_columns(html_context *ctx, const char *attributes, int nrows,
+                           const html_table_column *columns, int ncols, int header_row)
+{
+    if (!columns)
+        return -1;
+
+    html_table_source source = {html_emit_column, NULL, NULL, NULL, NULL, columns};
+    return html_build_table(ctx, attributes, nrows, ncols, header_row, &source);
+}
+
+//////////sibling batches///////
+
+static void *html_batch_alloc(html_context *ctx, size_t size)
+{
+    if ((ctx->flags & HTML_CONTEXT_ARENA) && ctx->arena)
+        return html_arena_alloc(ctx->arena, size);
+
+    // batch nodes share their block, so outside arena mode the blocks are
+    // kept by the context and returned at finalize
+    if (!ctx->batch_arena)
+    {
+        ctx->batch_arena = html_arena_create(HTML_ARENA_DEFAULT_BLOCK_SIZE);
+        if (!ctx->batch_arena)
+            return NULL;
+    }
+    return html_arena_alloc(ctx->batch_arena, size);
+}
+
+int html_add_children_batch(html_context *ctx, html_element *parent, int tag, const char *const *contents, int n,
+                            const char *attributes)
+{
+    if (!ctx || !parent || n < 0 || (!contents && n > 0))
+        return -1;
+
+    const char *tagname = html_tag_name(tag);
+    if (!tagname)
+    {
+        html_set_error_ex(HTML_ERROR_INVALID_ARGUMENT, "Unknown tag id %d", tag);
+        return -1;
+    }
+
+    if (!html_tag_is_valid_child(parent->tag, tag))
+    {
+        html_set_error_tags(HTML_ERROR_INVALID_CHILD, "Invalid child tag '%s' for parent '%s'", tag, parent->tag);
+        return -1;
+    }
+
+    if (n == 0)
+        return 0;
+
+    // the attributes are parsed once and each child gets a copy of the result
+    html_element shared;
+    memset(&shared, 0, sizeof(shared));
+    if (attributes && html_parse_attributes(&shared, attributes) != 0)
+    {
+        html_free_attributes(&shared);
+        return -1;
+    }
+
+    // every child would carry the same ID
+    if (shared.id)
+    {
+        html_free_attributes(&shared);
+        html_set_error_code(HTML_ERROR_INVALID_ARGUMENT, "Batch attributes cannot contain an ID");
+        return -1;
+    }
+
+    // the parsed array and its values are one contiguous run
+    size_t attribute_bytes = 0;
+    size_t attribute_stride = 0;
+    if (shared.attribute_count > 0)
+    {
+        attribute_bytes = shared.attribute_count * sizeof(html_attribute);
+        for (int a = 0; a < shared.attribute_count; a++)
+        {
+            if (shared.attributes[a].value)
+                attribute_bytes += shared.attributes[a].length + 1;
+        }
+        attribute_stride = (attribute_bytes + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+    }
+
+    size_t content_bytes = 0;
+    for (int i = 0; i < n; i++)
+    {
+        if (contents[i])
+            content_bytes += strlen(contents[i]) + 1;
+    }
+
+    if (!html_element_reserve_children(parent, parent->children_count + n))
+    {
+        html_free_attributes(&shared);
+        return -1;
+    }
+
+    size_t element_bytes = (size_t)n * sizeof(html_element);
+    char *block = (char *)html_batch_alloc(ctx, element_bytes + (size_t)n * attribute_stride + content_bytes);
+    if (!block)
+    {
+        html_free_attributes(&shared);
+        html_set_error_code(HTML_ERROR_MEMORY, "Memory allocation failed for HTML element");
+        return -1;
+    }
+
+    html_element *elements = (html_element *)block;
+    char *attribute_data = block + element_bytes;
+    char *strings = attribute_data + (size_t)n * attribute_stride;
+
+    for (int i = 0; i < n; i++)
+    {
+        html_element *element = &elements[i];
+        html_bulk_element_init(element, ctx, tag, tagname, parent);
+
+        if (contents[i])
+        {
+            size_t len = strlen(contents[i]);
+            memcpy(strings, contents[i], len + 1);
+            element->content = strings;
+            strings += len + 1;
+        }
+
+        if (attribute_bytes)
+        {
+            char *data = attribute_data + (size_t)i * attribute_stride;
+            memcpy(data, shared.attribute_data, attribute_bytes);
+
+            element->attributes = (html_attribute *)data;
+            element->attribute_count = shared.attribute_count;
+            element->attribute_capacity = shared.attribute_count;
+            for (int a = 0; a < shared.attribute_count; a++)
+            {
+                html_attribute *attr = &element->attributes[a];
+                if (attr->value)
+                    attr->value = data + (attr->value - (char *)shared.attribute_data);
+            }
+        }
+
+        parent->children[parent->children_count++] = element;
+    }
+    html_free_attributes(&shared);
+    html_mark_dirty(parent);
+
+    for (int i = 0; i < n; i++)
+        html_index_element(ctx, &elements[i]);
+
+    return 0;
+}
+
+int html_add_list_items(html_context *ctx, const char *const *items, int n, const char *attributes)
+{
+    if (!ctx || !ctx->current)
+        return -1;
+
+    if (ctx->current->tag != HTML_TAG_UL && ctx->current->tag != HTML_TAG_OL)
+    {
+        html_set_error_code(HTML_ERROR_INVALID_STATE, "Current element is not a list");
+        return -1;
+    }
+
+    return html_add_children_batch(ctx, ctx->current, HTML_TAG_LI, items, n, attributes);
+}
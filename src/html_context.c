@@ -7,38 +7,95 @@
 
 html_context *html_init_file(const char *filename, const char *title)
 {
-    if (!filename)
+    return html_init_file_ex(filename, title, 0);
+}
+
+static int html_flush_gzip_file(void *target, const char *data, size_t len)
+{
+    return fwrite(data, 1, len, (FILE *)target) == len;
+}
+
+static int html_open_gzip_copy(html_context *ctx, const char *filename)
+{
+    size_t len = strlen(filename);
+    char *path = (char *)malloc(len + 4);
+    if (!path)
     {
-        html_set_error("Filename cannot be NULL");
-        return NULL;
+        html_set_error_code(HTML_ERROR_MEMORY, "Memory allocation failed for gzip file name");
+        return 0;
     }
 
-    FILE *file = fopen(filename, "w");
-    if (!file)
+    memcpy(path, filename, len);
+    memcpy(path + len, ".gz", 4);
+
+    ctx->gzip_file = fopen(path, "wb");
+    if (!ctx->gzip_file)
     {
-        html_set_error("Failed to open output file '%s'", filename);
-        return NULL;
+        html_set_error_ex(HTML_ERROR_IO, "Failed to open output file '%s'", path);
+        free(path);
+        return 0;
+    }
+    free(path);
+
+    ctx->gzip = (html_gzip_sink *)malloc(sizeof(html_gzip_sink));
+    if (!ctx->gzip)
+    {
+        html_set_error_code(HTML_ERROR_MEMORY, "Memory allocation failed for gzip sink");
+        return 0;
+    }
+
+    return html_gzip_init(ctx->gzip, HTML_GZIP_DEFAULT_LEVEL, html_flush_gzip_file, ctx->gzip_file);
+}
+
+static void html_close_gzip_copy(html_context *ctx)
+{
+    if (ctx->gzip)
+    {
+        html_gzip_finish(ctx->gzip);
+        html_gzip_free(ctx->gzip);
+        free(ctx->gzip);
+        ctx->gzip = NULL;
     }
 
+    if (ctx->gzip_file)
+    {
+        fclose(ctx->gzip_file);
+        ctx->gzip_file = NULL;
+    }
+}
+
+int html_set_gzip_level(html_context *ctx, int level)
+{
+    if (!ctx || !ctx->gzip)
+    {
+        html_set_error_code(HTML_ERROR_INVALID_STATE, "Context was not opened with HTML_CONTEXT_GZIP");
+        return 0;
+    }
+
+    return html_gzip_set_level(ctx->gzip, level);
+}
+
+static html_context *html_create_context(html_sink *sink, const char *title, int flags)
+{
     html_context *ctx = (html_context *)malloc(sizeof(html_context));
     if (!ctx)
     {
-        fclose(file);
-        html_set_error("Memory allocation failed for HTML context");
+        html_sink_close(sink);
+        html_set_error_code(HTML_ERROR_MEMORY, "Memory allocation failed for HTML context");
         return NULL;
     }
 
     memset(ctx, 0, sizeof(html_context));
-    ctx->output_file = file;
+    ctx->sink = sink;
     ctx->indent_level = 0;
-
+    ctx->flags = flags;
 
     if (title)
     {
         ctx->title = html_strdup(title);
         if (!ctx->title)
         {
-            fclose(file);
+            html_sink_close(sink);
             free(ctx);
             return NULL;
         }
@@ -48,7 +105,7 @@ html_context *html_init_file(const char *filename, const char *title)
         ctx->title = html_strdup("Untitled Document");
         if (!ctx->title)
         {
-            fclose(file);
+            html_sink_close(sink);
             free(ctx);
             return NULL;
         }
@@ -58,11 +115,85 @@ html_context *html_init_file(const char *filename, const char *title)
     if (!ctx->element_map)
     {
         free(ctx->title);
-        fclose(file);
+        html_sink_close(sink);
         free(ctx);
         return NULL;
     }
 
+    if (flags & HTML_CONTEXT_ARENA)
+    {
+        ctx->arena = html_arena_create(HTML_ARENA_DEFAULT_BLOCK_SIZE);
+        if (!ctx->arena)
+        {
+            html_finalize(ctx);
+            return NULL;
+        }
+    }
+
+    return ctx;
+}
+
+html_context *html_init_file_ex(const char *filename, const char *title, int flags)
+{
+    if (!filename)
+    {
+        html_set_error_code(HTML_ERROR_INVALID_ARGUMENT, "Filename cannot be NULL");
+        return NULL;
+    }
+
+    FILE *file = fopen(filename, "w");
+    if (!file)
+    {
+        html_set_error_ex(HTML_ERROR_IO, "Failed to open output file '%s'", filename);
+        return NULL;
+    }
+
+    html_sink *sink = html_sink_file(file, 1);
+    if (!sink)
+    {
+        fclose(file);
+        return NULL;
+    }
+
+    html_context *ctx = html_create_context(sink, title, flags);
+    if (!ctx)
+        return NULL;
+
+    // the sink owns the file; output_file stays for callers that inspect it
+    ctx->output_file = file;
+
+    if ((flags & HTML_CONTEXT_GZIP) && !html_open_gzip_copy(ctx, filename))
+    {
+        html_finalize(ctx);
+        return NULL;
+    }
+
+    if (!html_create_document_structure(ctx))
+    {
+        html_finalize(ctx);
+        return NULL;
+    }
+
+    return ctx;
+}
+
+html_context *html_init_sink(html_sink *sink, const char *title)
+{
+    return html_init_sink_ex(sink, title, 0);
+}
+
+html_context *html_init_sink_ex(html_sink *sink, const char *title, int flags)
+{
+    if (!sink)
+    {
+        html_set_error_code(HTML_ERROR_INVALID_ARGUMENT, "Sink cannot be NULL");
+        return NULL;
+    }
+
+    html_context *ctx = html_create_context(sink, title, flags & ~HTML_CONTEXT_GZIP);
+    if (!ctx)
+        return NULL;
+
     if (!html_create_document_structure(ctx))
     {
         html_finalize(ctx);
@@ -79,13 +210,15 @@ int html_create_document_structure(html_context *ctx)
 
     char *html_attrs = NULL;
 
-    ctx->root = html_create_element("html", html_attrs, NULL);
+    ctx->root = html_create_element_tag(ctx, HTML_TAG_HTML, html_attrs, NULL);
     free(html_attrs);
 
     if (!ctx->root)
         return 0;
 
-    html_element *head = html_add_child(ctx, ctx->root, "head", NULL, NULL);
+    html_index_element(ctx, ctx->root);
+
+    html_element *head = html_add_child_tag(ctx, ctx->root, HTML_TAG_HEAD, NULL, NULL);
     if (!head)
     {
         html_free_element(ctx->root);
@@ -95,7 +228,7 @@ int html_create_document_structure(html_context *ctx)
 
     if (ctx->title)
     {
-        html_element *title = html_add_child(ctx, head, "title", NULL, ctx->title);
+        html_element *title = html_add_child_tag(ctx, head, HTML_TAG_TITLE, NULL, ctx->title);
         if (!title)
         {
             html_free_element(ctx->root);
@@ -104,7 +237,7 @@ int html_create_document_structure(html_context *ctx)
         }
     }
 
-    html_element *body = html_add_child(ctx, ctx->root, "body", NULL, NULL);
+    html_element *body = html_add_child_tag(ctx, ctx->root, HTML_TAG_BODY, NULL, NULL);
     if (!body)
     {
         html_free_element(ctx->root);
@@ -122,84 +255,134 @@ void html_finalize(html_context *ctx)
     if (!ctx)
         return;
 
-    if (ctx->output_file && ctx->root)
+    // a document already written by html_render or html_render_parallel is
+    // not written to the sink a second time
+    if (ctx->sink && ctx->root && !ctx->rendered)
     {
         html_render(ctx);
     }
+    html_stream_free(ctx);
+    html_render_cache_free(ctx);
+    html_close_gzip_copy(ctx);
 
-    if (ctx->root)
-    {
-        html_free_element(ctx->root);
-        ctx->root = NULL;
-    }
-
+    // the indexes go first so tearing down the tree does not unregister every element
     if (ctx->element_map)
     {
         html_free_id_map(ctx->element_map);
         ctx->element_map = NULL;
     }
+    html_free_indexes(ctx);
 
-    if (ctx->output_file)
+    // arena documents are dropped wholesale with the arena blocks below
+    if (ctx->root && !(ctx->flags & HTML_CONTEXT_ARENA))
     {
-        fclose(ctx->output_file);
-        ctx->output_file = NULL;
+        html_free_element(ctx->root);
     }
+    ctx->root = NULL;
+
+    html_sink_close(ctx->sink);
+    ctx->sink = NULL;
+    ctx->output_file = NULL;
     free(ctx->title);
 
+    html_arena_destroy(ctx->arena);
+    html_arena_destroy(ctx->batch_arena);
+
     free(ctx);
 }
 
-int html_register_element_by_id(html_context *ctx, html_element *element)
+int html_context_reset(html_context *ctx, const char *title)
 {
-    if (!ctx || !ctx->element_map || !element || !element->id)
+    if (!ctx)
         return 0;
 
-    if (ctx->element_map->size >= ctx->element_map->capacity * 0.75)
+    html_stream_free(ctx);
+    html_render_cache_free(ctx);
+
+    // the indexes are emptied in place and hidden while the old tree is torn
+    // down, so no element is unregistered one by one
+    html_table_clear(ctx->element_map);
+    html_reset_indexes(ctx);
+
+    id_map *element_map = ctx->element_map;
+    html_element_list *tag_index = ctx->tag_index;
+    ctx->element_map = NULL;
+    ctx->tag_index = NULL;
+
+    if (ctx->root && !(ctx->flags & HTML_CONTEXT_ARENA))
+        html_free_element(ctx->root);
+
+    ctx->element_map = element_map;
+    ctx->tag_index = tag_index;
+    ctx->root = NULL;
+    ctx->current = NULL;
+    ctx->indent_level = 0;
+    ctx->fragment_instances = 0;
+    ctx->rendered = 0;
+
+    // arena blocks are kept for the next document
+    html_arena_reset(ctx->arena);
+    html_arena_reset(ctx->batch_arena);
+
+    if (title)
     {
-        if (html_resize_id_map(ctx->element_map) != 1)
+        size_t len = strlen(title);
+        if (len > strlen(ctx->title))
         {
-            return 0;
+            char *copy = (char *)realloc(ctx->title, len + 1);
+            if (!copy)
+            {
+                html_set_error_code(HTML_ERROR_MEMORY, "Memory allocation failed for HTML context");
+                return 0;
+            }
+            ctx->title = copy;
         }
+        memcpy(ctx->title, title, len + 1);
     }
 
-    unsigned int index = html_code_string(element->id) % ctx->element_map->capacity;
+    return html_create_document_structure(ctx);
+}
+
+int html_register_element_by_id(html_context *ctx, html_element *element)
+{
+    if (!ctx || !ctx->element_map || !element || !element->id)
+        return 0;
 
-    while (ctx->element_map->keys[index] != NULL)
+    int result = html_table_insert(ctx->element_map, element->id, element);
+    if (result == 0)
     {
-        if (strcmp(ctx->element_map->keys[index], element->id) == 1)
-        {
-            html_set_error("Duplicate element ID: '%s'", element->id);
-            return 0;
-        }
-        index = (index + 1) % ctx->element_map->capacity;
-    }
+        if (html_table_get(ctx->element_map, element->id) == element)
+            return 1;
 
-    ctx->element_map->keys[index] = element->id;
-    ctx->element_map->values[index] = element;
-    ctx->element_map->size++;
+        html_set_error_ex(HTML_ERROR_DUPLICATE_ID, "Duplicate element ID: '%s'", element->id);
+        return 0;
+    }
+    if (result < 0)
+        return 0;
 
+    element->flags |= HTML_ELEMENT_ID_INDEXED;
     return 1;
 }
 
+int html_unregister_element_by_id(html_context *ctx, html_element *element)
+{
+    if (!element || !(element->flags & HTML_ELEMENT_ID_INDEXED))
+        return 0;
+
+    element->flags &= ~HTML_ELEMENT_ID_INDEXED;
+
+    if (!ctx || !ctx->element_map || !element->id)
+        return 0;
+
+    return html_table_remove(ctx->element_map, element->id, element);
+}
+
 html_element *html_get_element_by_id(html_context *ctx, const char *id)
 {
     if (!ctx || !ctx->element_map || !id)
         return NULL;
 
-    unsigned int index = html_code_string(id) % ctx->element_map->capacity;
-
-    int i = 0;
-    while (ctx->element_map->keys[index] != NULL && i < ctx->element_map->capacity)
-    {
-        if (ctx->element_map->keys[index] && strcmp(ctx->element_map->keys[index], id) == 0)
-        {
-            return ctx->element_map->values[index];
-        }
-        index = (index + 1) % ctx->element_map->capacity;
-        i++;
-    }
-
-    return NULL;
+    return (html_element *)html_table_get(ctx->element_map, id);
 }
 
 int html_set_current_element(html_context *ctx, html_element *element)
@@ -219,7 +402,7 @@ int html_add_style(html_context *ctx, const char *style_content)
     html_element *head = html_find_head(ctx);
     if (!head)
     {
-        html_set_error("Could not find head element");
+        html_set_error_code(HTML_ERROR_NOT_FOUND, "Could not find head element");
         return 0;
     }
 
@@ -227,7 +410,7 @@ int html_add_style(html_context *ctx, const char *style_content)
 
     ctx->current = head;
 
-    html_element *style = html_add_child(ctx, head, "style", NULL, style_content);
+    html_element *style = html_add_child_tag(ctx, head, HTML_TAG_STYLE, NULL, style_content);
 
     ctx->current = saved_current;
 
@@ -242,7 +425,7 @@ int html_add_script(html_context *ctx, const char *script_content, int is_extern
     html_element *head = html_find_head(ctx);
     if (!head)
     {
-        html_set_error("Could not find head element");
+        html_set_error_code(HTML_ERROR_NOT_FOUND, "Could not find head element");
         return 0;
     }
 
@@ -254,12 +437,12 @@ int html_add_script(html_context *ctx, const char *script_content, int is_extern
     if (is_external)
     {
         char *attrs = html_add_attribute(NULL, "src", script_content);
-        script = html_add_child(ctx, head, "script", attrs, NULL);
+        script = html_add_child_tag(ctx, head, HTML_TAG_SCRIPT, attrs, NULL);
         free(attrs);
     }
     else
     {
-        script = html_add_child(ctx, head, "script", NULL, script_content);
+        script = html_add_child_tag(ctx, head, HTML_TAG_SCRIPT, NULL, script_content);
     }
 
     ctx->current = saved_current;
@@ -275,7 +458,7 @@ int html_add_meta(html_context *ctx, const char *name, const char *content)
     html_element *head = html_find_head(ctx);
     if (!head)
     {
-        html_set_error("Could not find head element");
+        html_set_error_code(HTML_ERROR_NOT_FOUND, "Could not find head element");
         return 0;
     }
 
@@ -299,7 +482,7 @@ int html_add_meta(html_context *ctx, const char *name, const char *content)
         return 0;
     }
 
-    html_element *meta = html_add_child(ctx, head, "meta", attrs_with_content, NULL);
+    html_element *meta = html_add_child_tag(ctx, head, HTML_TAG_META, attrs_with_content, NULL);
     free(attrs_with_content);
 
     ctx->current = saved_current;
@@ -315,7 +498,7 @@ int html_add_link(html_context *ctx, const char *rel, const char *href, const ch
     html_element *head = html_find_head(ctx);
     if (!head)
     {
-        html_set_error("Could not find head element");
+        html_set_error_code(HTML_ERROR_NOT_FOUND, "Could not find head element");
         return 0;
     }
 
@@ -352,84 +535,10 @@ int html_add_link(html_context *ctx, const char *rel, const char *href, const ch
         }
     }
 
-    html_element *link = html_add_child(ctx, head, "link", final_attrs, NULL);
+    html_element *link = html_add_child_tag(ctx, head, HTML_TAG_LINK, final_attrs, NULL);
     free(final_attrs);
 
     ctx->current = saved_current;
 
     return link ? 1: 0;
 }
-
-int html_render(html_context *ctx)
-{
-    if (!ctx || !ctx->root || !ctx->output_file)
-        return 0;
-
-    fprintf(ctx->output_file, "<!DOCTYPE html>\n");
-
-    ctx->indent_level = 1;
-    return html_render_element(ctx, ctx->root);
-}
-
-int html_render_element(html_context *ctx, html_element *element)
-{
-    if (!ctx || !element || !ctx->output_file)
-        return 0;
-
-    char *indent = html_generate_indent(ctx->indent_level);
-    if (!indent)
-        return 0;
-
-    fprintf(ctx->output_file, "%s<%s", indent, element->tagname);
-
-    if (element->attributes && strlen(element->attributes) > 0)
-    {
-        fprintf(ctx->output_file, " %s", element->attributes);
-    }
-
-    if (html_is_self_closing(element->tagname))
-    {
-        fprintf(ctx->output_file, " />\n");
-        free(indent);
-        return 1;
-    }
-
-    fprintf(ctx->output_file, ">");
-
-    int is_block = html_is_block_element(element->tagname);
-
-    if (element->content && strlen(element->content) > 0)
-    {
-        if (is_block)
-        {
-            fprintf(ctx->output_file, "\n%s  ", indent);
-        }
-
-        fprintf(ctx->output_file, "%s", element->content);
-
-        if (is_block)
-        {
-            fprintf(ctx->output_file, "\n%s", indent);
-        }
-    }
-    else if (element->children_count > 0)
-    {
-        fprintf(ctx->output_file, "\n");
-
-        ctx->indent_level++;
-
-        for (int i = 0; i < element->children_count; i++)
-        {
-            html_render_element(ctx, element->children[i]);
-        }
-
-        ctx->indent_level--;
-
-        fprintf(ctx->output_file, "%s", indent);
-    }
-
-    fprintf(ctx->output_file, "</%s>\n", element->tagname);
-
-    free(indent);
-    return 1;
-}
\ No newline at end of file
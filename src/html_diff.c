@@ -0,0 +1,791 @@
+#include "HTML.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+// how far ahead an unkeyed child may be matched by tag before it counts as inserted
+#define HTML_DIFF_LOOKAHEAD 8
+
+typedef struct
+{
+    const html_element *old_element;
+    const html_element *new_element;
+    int depth;
+    int index;
+    int matches;
+} html_diff_pair;
+
+// the old element paired with one new child, and whether it stays in its place
+typedef struct
+{
+    const html_element *old_element;
+    int old_index;
+    int kept;
+} html_diff_match;
+
+enum
+{
+    HTML_DIFF_CLAIMED = 1,
+    HTML_DIFF_KEPT,
+    HTML_DIFF_DETACHED,
+    HTML_DIFF_MOVED
+};
+
+// what happens to an old keyed element that has a partner in the new document
+typedef struct
+{
+    const html_element *element;
+    int state;
+    int index;
+} html_diff_claim;
+
+typedef struct
+{
+    const html_context *old_ctx;
+    const html_context *new_ctx;
+    html_patch *patch;
+    int *path;
+    int path_length;
+    int path_capacity;
+    html_diff_pair *stack;
+    int stack_count;
+    int stack_capacity;
+    html_diff_pair *pairs;
+    int pair_count;
+    int pair_capacity;
+    html_diff_match *matches;
+    int match_count;
+    int match_capacity;
+    html_diff_claim *claims;
+    int claim_count;
+    int claim_capacity;
+    int pending;
+    int failed;
+} html_diff_state;
+
+static const char *html_patch_type_names[] = {
+    "content",
+    "attr",
+    "remove-attr",
+    "insert",
+    "remove",
+    "move",
+    "detach",
+};
+
+static html_patch_op *html_patch_add(html_diff_state *state, html_patch_type type, const html_element *target)
+{
+    html_patch *patch = state->patch;
+    if (patch->count >= patch->capacity)
+    {
+        int new_capacity = patch->capacity ? patch->capacity * 2 : 16;
+        html_patch_op *ops = (html_patch_op *)realloc(patch->ops, new_capacity * sizeof(html_patch_op));
+        if (!ops)
+        {
+            html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for patch");
+            state->failed = 1;
+            return NULL;
+        }
+        patch->ops = ops;
+        patch->capacity = new_capacity;
+    }
+
+    html_patch_op *op = &patch->ops[patch->count];
+    memset(op, 0, sizeof(html_patch_op));
+    op->type = type;
+    op->index = -1;
+
+    if (state->path_length > 0)
+    {
+        op->path = (int *)malloc(state->path_length * sizeof(int));
+        if (!op->path)
+        {
+            html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for patch");
+            state->failed = 1;
+            return NULL;
+        }
+        memcpy(op->path, state->path, state->path_length * sizeof(int));
+    }
+    op->path_length = state->path_length;
+
+    if (target->id)
+    {
+        op->id = html_strdup(target->id);
+        if (!op->id)
+        {
+            free(op->path);
+            state->failed = 1;
+            return NULL;
+        }
+    }
+
+    patch->count++;
+    return op;
+}
+
+static int html_patch_set_string(html_diff_state *state, char **field, const char *value)
+{
+    *field = html_strdup(value ? value : "");
+    if (!*field)
+    {
+        state->failed = 1;
+        return 0;
+    }
+    return 1;
+}
+
+static int html_has_content(const html_element *element)
+{
+    return element->content && element->content[0];
+}
+
+static void html_diff_attributes(html_diff_state *state, const html_element *old_element, const html_element *new_element)
+{
+    for (int i = 0; i < new_element->attribute_count && !state->failed; i++)
+    {
+        const html_attribute *attr = &new_element->attributes[i];
+        const html_attribute *previous = html_find_attribute(old_element, attr->name);
+
+        if (previous && (previous->value == attr->value ||
+                         (previous->value && attr->value && strcmp(previous->value, attr->value) == 0)))
+            continue;
+
+        html_patch_op *op = html_patch_add(state, HTML_PATCH_SET_ATTRIBUTE, new_element);
+        if (op && html_patch_set_string(state, &op->name, attr->name))
+            html_patch_set_string(state, &op->value, attr->value);
+    }
+
+    for (int i = 0; i < old_element->attribute_count && !state->failed; i++)
+    {
+        const html_attribute *attr = &old_element->attributes[i];
+        if (html_find_attribute(new_element, attr->name))
+            continue;
+
+        html_patch_op *op = html_patch_add(state, HTML_PATCH_REMOVE_ATTRIBUTE, new_element);
+        if (op)
+            html_patch_set_string(state, &op->name, attr->name);
+    }
+}
+
+static void html_diff_insert(html_diff_state *state, const html_element *parent, const html_element *child, int index)
+{
+    html_patch_op *op = html_patch_add(state, HTML_PATCH_INSERT_CHILD, parent);
+    if (!op)
+        return;
+
+    op->index = index;
+
+    html_render_options options;
+    html_render_options_init(&options);
+    options.flags = HTML_RENDER_MINIFIED;
+
+    html_writer writer;
+    if (!html_writer_init(&writer, 256, NULL, NULL))
+    {
+        state->failed = 1;
+        return;
+    }
+
+    html_write_element_ex(&writer, child, 0, &options);
+    html_writer_putc(&writer, '\0');
+
+    if (writer.error)
+    {
+        html_writer_free(&writer);
+        state->failed = 1;
+        return;
+    }
+    op->value = writer.data;
+}
+
+static int html_diff_reserve(html_diff_state *state, void **items, int *capacity, int needed, size_t size)
+{
+    if (needed <= *capacity)
+        return 1;
+
+    int new_capacity = *capacity ? *capacity * 2 : 64;
+    while (new_capacity < needed)
+        new_capacity *= 2;
+
+    void *grown = realloc(*items, new_capacity * size);
+    if (!grown)
+    {
+        html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for diff");
+        state->failed = 1;
+        return 0;
+    }
+    *items = grown;
+    *capacity = new_capacity;
+    return 1;
+}
+
+static int html_diff_push(html_diff_state *state, const html_element *old_element, const html_element *new_element,
+                          int depth, int index)
+{
+    if (!html_diff_reserve(state, (void **)&state->stack, &state->stack_capacity, state->stack_count + 1,
+                           sizeof(html_diff_pair)))
+        return 0;
+
+    html_diff_pair *pair = &state->stack[state->stack_count++];
+    pair->old_element = old_element;
+    pair->new_element = new_element;
+    pair->depth = depth;
+    pair->index = index;
+    pair->matches = -1;
+    return 1;
+}
+
+//////////keyed elements///////
+
+static unsigned int html_diff_hash(const html_element *element, int capacity)
+{
+    uint64_t key = (uint64_t)(uintptr_t)element;
+    return (unsigned int)((key * 0x9E3779B97F4A7C15ULL) >> 32) & (unsigned int)(capacity - 1);
+}
+
+static html_diff_claim *html_diff_claim_get(html_diff_state *state, const html_element *element, int create)
+{
+    if (create && (state->claim_count + 1) * 2 > state->claim_capacity)
+    {
+        int capacity = state->claim_capacity ? state->claim_capacity * 2 : 64;
+        html_diff_claim *claims = (html_diff_claim *)calloc(capacity, sizeof(html_diff_claim));
+        if (!claims)
+        {
+            html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for diff");
+            state->failed = 1;
+            return NULL;
+        }
+
+        for (int i = 0; i < state->claim_capacity; i++)
+        {
+            if (!state->claims[i].element)
+                continue;
+
+            unsigned int slot = html_diff_hash(state->claims[i].element, capacity);
+            while (claims[slot].element)
+                slot = (slot + 1) & (unsigned int)(capacity - 1);
+            claims[slot] = state->claims[i];
+        }
+        free(state->claims);
+        state->claims = claims;
+        state->claim_capacity = capacity;
+    }
+
+    if (!state->claim_capacity)
+        return NULL;
+
+    unsigned int mask = (unsigned int)state->claim_capacity - 1;
+    unsigned int slot = html_diff_hash(element, state->claim_capacity);
+    for (; state->claims[slot].element; slot = (slot + 1) & mask)
+    {
+        if (state->claims[slot].element == element)
+            return &state->claims[slot];
+    }
+
+    if (!create)
+        return NULL;
+
+    state->claims[slot].element = element;
+    state->claims[slot].state = 0;
+    state->claims[slot].index = -1;
+    state->claim_count++;
+    return &state->claims[slot];
+}
+
+// only elements that reach the client can be moved there; content replaces
+// the children in the rendered output
+static int html_diff_rendered(const html_context *ctx, const html_element *element)
+{
+    while (element->parent)
+    {
+        element = element->parent;
+        if (html_has_content(element))
+            return 0;
+    }
+    return element == ctx->root;
+}
+
+// the element with the same ID and tag in the other document
+static const html_element *html_diff_partner(const html_context *ctx, const html_element *element)
+{
+    if (!element->id || !ctx->element_map)
+        return NULL;
+
+    const html_element *partner = (const html_element *)html_table_get(ctx->element_map, element->id);
+    if (!partner || partner->tag != element->tag || !partner->parent)
+        return NULL;
+    return partner;
+}
+
+//////////matching///////
+
+// content replaces the children in the rendered output, so it wins here too
+static int html_diff_children_matched(const html_element *old_element, const html_element *new_element)
+{
+    return !html_has_content(new_element) && !html_has_content(old_element);
+}
+
+// pairs every new child with an old element: by ID anywhere in the old
+// document, otherwise by tag among the unkeyed old children in order; matched
+// children are queued so the walk continues below them
+static void html_diff_match_children(html_diff_state *state, html_diff_pair *pair)
+{
+    const html_element *old_element = pair->old_element;
+    const html_element *new_element = pair->new_element;
+    int old_count = old_element->children_count;
+    int new_count = new_element->children_count;
+
+    if (!html_diff_reserve(state, (void **)&state->matches, &state->match_capacity, state->match_count + new_count,
+                           sizeof(html_diff_match)))
+        return;
+
+    pair->matches = state->match_count;
+    state->match_count += new_count;
+
+    // keyed children that stay under this parent note where they are, so the
+    // order check below sees them next to the children matched by tag
+    for (int i = 0; i < old_count; i++)
+    {
+        const html_element *child = old_element->children[i];
+        const html_element *partner = html_diff_partner(state->new_ctx, child);
+        if (!partner || partner->parent != new_element)
+            continue;
+
+        html_diff_claim *claim = html_diff_claim_get(state, child, 1);
+        if (!claim)
+            return;
+        claim->index = i;
+    }
+
+    int cursor = 0;
+    int last = -1;
+    for (int i = 0; i < new_count; i++)
+    {
+        const html_element *child = new_element->children[i];
+        html_diff_match *match = &state->matches[pair->matches + i];
+        match->old_element = NULL;
+        match->old_index = -1;
+        match->kept = 0;
+
+        if (child->id)
+        {
+            const html_element *found = html_diff_partner(state->old_ctx, child);
+            if (!found || !html_diff_rendered(state->old_ctx, found))
+                continue;
+
+            html_diff_claim *claim = html_diff_claim_get(state, found, 1);
+            if (!claim)
+                return;
+            if (claim->state)
+                continue;
+
+            match->old_element = found;
+            match->old_index = found->parent == old_element ? claim->index : -1;
+            if (match->old_index > last)
+            {
+                match->kept = 1;
+                last = match->old_index;
+                claim->state = HTML_DIFF_KEPT;
+            }
+            else
+            {
+                claim->state = HTML_DIFF_CLAIMED;
+                state->pending++;
+            }
+            continue;
+        }
+
+        // the lookahead skips keyed siblings, they are matched by ID or not at all
+        for (int k = cursor, seen = 0; k < old_count && seen < HTML_DIFF_LOOKAHEAD; k++)
+        {
+            const html_element *candidate = old_element->children[k];
+            if (candidate->id)
+                continue;
+
+            if (candidate->tag == child->tag)
+            {
+                cursor = k + 1;
+                // an unkeyed child out of order has nothing to be moved by
+                if (k > last)
+                {
+                    match->old_element = candidate;
+                    match->old_index = k;
+                    match->kept = 1;
+                    last = k;
+                }
+                break;
+            }
+            seen++;
+        }
+    }
+
+    // pushed in reverse so siblings are visited in document order
+    for (int i = new_count - 1; i >= 0 && !state->failed; i--)
+    {
+        const html_diff_match *match = &state->matches[pair->matches + i];
+        if (match->old_element)
+            html_diff_push(state, match->old_element, new_element->children[i], pair->depth + 1, i);
+    }
+}
+
+//////////patch operations///////
+
+static void html_diff_detach(html_diff_state *state, html_diff_claim *claim)
+{
+    const html_element *element = claim->element;
+    claim->state = HTML_DIFF_DETACHED;
+    state->pending--;
+
+    // a detached element is named by its ID alone
+    int path_length = state->path_length;
+    state->path_length = 0;
+    html_patch_add(state, HTML_PATCH_DETACH_CHILD, element);
+    state->path_length = path_length;
+}
+
+// elements that move somewhere else are taken out of a subtree before the
+// subtree is dropped, so their moves still find them
+static void html_diff_detach_within(html_diff_state *state, const html_element *element)
+{
+    if (!state->pending)
+        return;
+
+    state->stack_count = 0;
+    for (int i = element->children_count - 1; i >= 0; i--)
+    {
+        if (!html_diff_push(state, element->children[i], NULL, 0, 0))
+            return;
+    }
+
+    while (state->stack_count > 0 && state->pending > 0 && !state->failed)
+    {
+        const html_element *child = state->stack[--state->stack_count].old_element;
+        html_diff_claim *claim = child->id ? html_diff_claim_get(state, child, 0) : NULL;
+        if (claim && claim->state == HTML_DIFF_CLAIMED)
+        {
+            html_diff_detach(state, claim);
+            continue;
+        }
+
+        if (html_has_content(child))
+            continue;
+        for (int i = child->children_count - 1; i >= 0; i--)
+        {
+            if (!html_diff_push(state, child->children[i], NULL, 0, 0))
+                return;
+        }
+    }
+}
+
+static void html_diff_move(html_diff_state *state, const html_element *parent, const html_element *child,
+                           const html_element *old_child, int index)
+{
+    html_diff_claim *claim = html_diff_claim_get(state, old_child, 0);
+    if (claim->state == HTML_DIFF_CLAIMED)
+        state->pending--;
+    claim->state = HTML_DIFF_MOVED;
+
+    html_patch_op *op = html_patch_add(state, HTML_PATCH_MOVE_CHILD, parent);
+    if (!op)
+        return;
+
+    op->index = index;
+    html_patch_set_string(state, &op->value, child->id);
+}
+
+static void html_diff_children(html_diff_state *state, const html_diff_pair *pair)
+{
+    const html_element *old_element = pair->old_element;
+    const html_element *new_element = pair->new_element;
+    int old_count = old_element->children_count;
+    int new_count = new_element->children_count;
+    const html_diff_match *matches = &state->matches[pair->matches];
+
+    // kept children appear in the matches in increasing old order, so both
+    // passes below walk them alongside the old children; children moving
+    // elsewhere leave first
+    int present = 0;
+    for (int i = 0, k = 0; i < old_count && !state->failed; i++)
+    {
+        while (k < new_count && !matches[k].kept)
+            k++;
+        if (k < new_count && matches[k].old_index == i)
+        {
+            k++;
+            present++;
+            continue;
+        }
+
+        const html_element *child = old_element->children[i];
+        html_diff_claim *claim = child->id ? html_diff_claim_get(state, child, 0) : NULL;
+        if (claim && claim->state == HTML_DIFF_CLAIMED)
+            html_diff_detach(state, claim);
+        else if (!claim || !claim->state)
+        {
+            html_diff_detach_within(state, child);
+            present++;
+        }
+    }
+
+    for (int i = old_count - 1, k = new_count - 1; i >= 0 && !state->failed; i--)
+    {
+        while (k >= 0 && !matches[k].kept)
+            k--;
+        if (k >= 0 && matches[k].old_index == i)
+        {
+            k--;
+            present--;
+            continue;
+        }
+
+        const html_element *child = old_element->children[i];
+        html_diff_claim *claim = child->id ? html_diff_claim_get(state, child, 0) : NULL;
+        if (claim && claim->state)
+            continue;
+
+        html_patch_op *op = html_patch_add(state, HTML_PATCH_REMOVE_CHILD, new_element);
+        if (op)
+            op->index = --present;
+    }
+
+    for (int i = 0; i < new_count && !state->failed; i++)
+    {
+        if (!matches[i].old_element)
+            html_diff_insert(state, new_element, new_element->children[i], i);
+        else if (!matches[i].kept)
+            html_diff_move(state, new_element, new_element->children[i], matches[i].old_element, i);
+    }
+}
+
+static void html_diff_pair_elements(html_diff_state *state, const html_diff_pair *pair)
+{
+    const html_element *old_element = pair->old_element;
+    const html_element *new_element = pair->new_element;
+
+    html_diff_attributes(state, old_element, new_element);
+    if (state->failed)
+        return;
+
+    if (html_has_content(new_element))
+    {
+        if (!html_has_content(old_element) || strcmp(old_element->content, new_element->content) != 0)
+        {
+            if (!html_has_content(old_element))
+                html_diff_detach_within(state, old_element);
+
+            html_patch_op *op = html_patch_add(state, HTML_PATCH_SET_CONTENT, new_element);
+            if (op)
+                html_patch_set_string(state, &op->value, new_element->content);
+        }
+        return;
+    }
+
+    if (html_has_content(old_element))
+    {
+        html_patch_op *op = html_patch_add(state, HTML_PATCH_SET_CONTENT, new_element);
+        if (!op || !html_patch_set_string(state, &op->value, ""))
+            return;
+
+        for (int i = 0; i < new_element->children_count && !state->failed; i++)
+            html_diff_insert(state, new_element, new_element->children[i], i);
+        return;
+    }
+
+    html_diff_children(state, pair);
+}
+
+html_patch *html_diff(html_context *old_ctx, html_context *new_ctx)
+{
+    html_clear_error();
+
+    if (!old_ctx || !new_ctx || !old_ctx->root || !new_ctx->root)
+    {
+        html_set_error_code(HTML_ERROR_INVALID_ARGUMENT, "Invalid HTML contexts for diff");
+        return NULL;
+    }
+
+    html_patch *patch = (html_patch *)calloc(1, sizeof(html_patch));
+    if (!patch)
+    {
+        html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for patch");
+        return NULL;
+    }
+
+    html_diff_state state;
+    memset(&state, 0, sizeof(state));
+    state.old_ctx = old_ctx;
+    state.new_ctx = new_ctx;
+    state.patch = patch;
+
+    // the whole tree is matched first, so a keyed element leaving one parent
+    // is known to arrive under another before any operation is written
+    html_diff_push(&state, old_ctx->root, new_ctx->root, 0, 0);
+    while (state.stack_count > 0 && !state.failed)
+    {
+        html_diff_pair pair = state.stack[--state.stack_count];
+        if (!html_diff_reserve(&state, (void **)&state.pairs, &state.pair_capacity, state.pair_count + 1,
+                               sizeof(html_diff_pair)))
+            break;
+
+        if (html_diff_children_matched(pair.old_element, pair.new_element))
+            html_diff_match_children(&state, &pair);
+        state.pairs[state.pair_count++] = pair;
+    }
+
+    for (int i = 0; i < state.pair_count && !state.failed; i++)
+    {
+        const html_diff_pair *pair = &state.pairs[i];
+
+        // the path of the pair replaces everything at and below its depth
+        if (pair->depth > 0)
+        {
+            if (!html_diff_reserve(&state, (void **)&state.path, &state.path_capacity, pair->depth, sizeof(int)))
+                break;
+            state.path[pair->depth - 1] = pair->index;
+        }
+        state.path_length = pair->depth;
+
+        html_diff_pair_elements(&state, pair);
+    }
+
+    free(state.path);
+    free(state.stack);
+    free(state.pairs);
+    free(state.matches);
+    free(state.claims);
+
+    if (state.failed)
+    {
+        html_patch_free(patch);
+        return NULL;
+    }
+
+    return patch;
+}
+
+void html_patch_free(html_patch *patch)
+{
+    if (!patch)
+        return;
+
+    for (int i = 0; i < patch->count; i++)
+    {
+        free(patch->ops[i].path);
+        free(patch->ops[i].id);
+        free(patch->ops[i].name);
+        free(patch->ops[i].value);
+    }
+    free(patch->ops);
+    free(patch);
+}
+
+static void html_json_string(html_writer *writer, const char *str)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    html_writer_putc(writer, '"');
+
+    const char *run = str;
+    for (const char *cursor = str; *cursor; cursor++)
+    {
+        unsigned char c = (unsigned char)*cursor;
+        if (c >= 0x20 && c != '"' && c != '\\')
+            continue;
+
+        html_writer_append(writer, run, cursor - run);
+        run = cursor + 1;
+
+        switch (c)
+        {
+        case '"':
+            html_writer_append(writer, "\\\"", 2);
+            break;
+        case '\\':
+            html_writer_append(writer, "\\\\", 2);
+            break;
+        case '\n':
+            html_writer_append(writer, "\\n", 2);
+            break;
+        case '\r':
+            html_writer_append(writer, "\\r", 2);
+            break;
+        case '\t':
+            html_writer_append(writer, "\\t", 2);
+            break;
+        default:
+        {
+            char escape[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF]};
+            html_writer_append(writer, escape, sizeof(escape));
+            break;
+        }
+        }
+    }
+
+    html_writer_puts(writer, run);
+    html_writer_putc(writer, '"');
+}
+
+char *html_patch_to_json(const html_patch *patch)
+{
+    if (!patch)
+        return NULL;
+
+    html_writer writer;
+    if (!html_writer_init(&writer, 256, NULL, NULL))
+        return NULL;
+
+    char number[HTML_NUMBER_BUFFER_SIZE];
+    html_writer_putc(&writer, '[');
+
+    for (int i = 0; i < patch->count; i++)
+    {
+        const html_patch_op *op = &patch->ops[i];
+        if (i > 0)
+            html_writer_putc(&writer, ',');
+
+        html_writer_puts(&writer, "{\"op\":\"");
+        html_writer_puts(&writer, html_patch_type_names[op->type]);
+        html_writer_puts(&writer, "\",\"path\":[");
+        for (int j = 0; j < op->path_length; j++)
+        {
+            if (j > 0)
+                html_writer_putc(&writer, ',');
+            html_writer_append(&writer, number, (size_t)html_format_int(number, op->path[j]));
+        }
+        html_writer_putc(&writer, ']');
+
+        if (op->id)
+        {
+            html_writer_puts(&writer, ",\"id\":");
+            html_json_string(&writer, op->id);
+        }
+        if (op->name)
+        {
+            html_writer_puts(&writer, ",\"name\":");
+            html_json_string(&writer, op->name);
+        }
+        if (op->index >= 0)
+        {
+            html_writer_puts(&writer, ",\"index\":");
+            html_writer_append(&writer, number, (size_t)html_format_int(number, op->index));
+        }
+        if (op->value)
+        {
+            html_writer_puts(&writer, ",\"value\":");
+            html_json_string(&writer, op->value);
+        }
+
+        html_writer_putc(&writer, '}');
+    }
+
+    html_writer_append(&writer, "]", 2);
+
+    if (writer.error)
+    {
+        html_writer_free(&writer);
+        return NULL;
+    }
+
+    return writer.data;
+}
@@ -5,68 +5,175 @@
 #include <stdarg.h>
 #include <ctype.h>
 
+int html_element_in_arena(const html_element *element)
+{
+    return element->owner && (element->owner->flags & HTML_CONTEXT_ARENA) && element->owner->arena;
+}
+
+void *html_element_alloc(html_element *element, size_t size, unsigned int field)
+{
+    if (html_element_in_arena(element))
+    {
+        element->flags &= ~field;
+        void *ptr = html_arena_alloc(element->owner->arena, size);
+        if (!ptr)
+            html_set_error_code(HTML_ERROR_MEMORY, "Memory allocation failed for HTML element");
+        return ptr;
+    }
+
+    void *ptr = malloc(size);
+    if (!ptr)
+    {
+        html_set_error_code(HTML_ERROR_MEMORY, "Memory allocation failed for HTML element");
+        return NULL;
+    }
+
+    element->flags |= field;
+    return ptr;
+}
+
+void html_element_release(html_element *element, void *ptr, unsigned int field)
+{
+    if (element->flags & field)
+        free(ptr);
+
+    element->flags &= ~field;
+}
+
+char *html_element_strdup(html_element *element, const char *str, unsigned int field)
+{
+    if (!str)
+        return NULL;
+
+    size_t len = strlen(str);
+    char *copy = (char *)html_element_alloc(element, len + 1, field);
+    if (!copy)
+        return NULL;
+
+    memcpy(copy, str, len + 1);
+    return copy;
+}
+
 html_element *html_create_element(const char *tagname, const char *attributes, const char *content)
+{
+    return html_create_element_in(NULL, tagname, attributes, content);
+}
+
+html_element *html_create_element_in(html_context *ctx, const char *tagname, const char *attributes, const char *content)
 {
     if (!tagname)
         return NULL;
 
-    html_element *element = (html_element *)malloc(sizeof(html_element));
-    if (!element)
+    int tag = html_tag_intern(tagname);
+    if (tag < 0)
+        return NULL;
+
+    return html_create_element_tag(ctx, tag, attributes, content);
+}
+
+html_element *html_create_element_tag(html_context *ctx, int tag, const char *attributes, const char *content)
+{
+    const char *tagname = html_tag_name(tag);
+    if (!tagname)
     {
-        html_set_error("Memory allocation failed for HTML element");
+        html_set_error_ex(HTML_ERROR_INVALID_ARGUMENT, "Unknown tag id %d", tag);
         return NULL;
     }
 
-    memset(element, 0, sizeof(html_element));
+    html_element *element;
+    unsigned int flags = 0;
+    if (ctx && (ctx->flags & HTML_CONTEXT_ARENA) && ctx->arena)
+    {
+        element = (html_element *)html_arena_alloc(ctx->arena, sizeof(html_element));
+    }
+    else
+    {
+        element = (html_element *)malloc(sizeof(html_element));
+        flags = HTML_ELEMENT_OWNS_SELF;
+    }
 
-    element->tagname = html_strdup(tagname);
-    if (!element->tagname)
+    if (!element)
     {
-        free(element);
+        html_set_error_code(HTML_ERROR_MEMORY, "Memory allocation failed for HTML element");
         return NULL;
     }
 
+    memset(element, 0, sizeof(html_element));
+    element->owner = ctx;
+    element->flags = flags | HTML_ELEMENT_DIRTY;
+
+    element->tag = tag;
+    element->tagname = tagname;
+
     if (content)
     {
-        element->content = html_strdup(content);
+        element->content = html_element_strdup(element, content, HTML_ELEMENT_OWNS_CONTENT);
         if (!element->content)
         {
-            free(element->tagname);
-            free(element);
+            html_free_element(element);
             return NULL;
         }
     }
 
-    if (attributes)
+    if (attributes && html_parse_attributes(element, attributes) != 0)
     {
-        element->attributes = html_strdup(attributes);
-        if (!element->attributes)
+        html_free_element(element);
+        return NULL;
+    }
+
+    // children arrays are allocated on first use so leaf elements cost no extra allocation
+    return element;
+}
+
+int html_element_reserve_children(html_element *element, int capacity)
+{
+    if (!element)
+        return 0;
+
+    if (capacity <= element->children_capacity)
+        return 1;
+
+    int new_capacity = element->children_capacity ? element->children_capacity : 4;
+    while (new_capacity < capacity)
+        new_capacity *= 2;
+
+    html_element **new_children;
+    if (html_element_in_arena(element))
+    {
+        new_children = (html_element **)html_arena_realloc(element->owner->arena, element->children,
+                                                           element->children_capacity * sizeof(html_element *),
+                                                           new_capacity * sizeof(html_element *));
+    }
+    else if ((element->flags & HTML_ELEMENT_OWNS_CHILDREN) || !element->children)
+    {
+        new_children = (html_element **)realloc(element->children, new_capacity * sizeof(html_element *));
+        if (new_children)
+            element->flags |= HTML_ELEMENT_OWNS_CHILDREN;
+    }
+    else
+    {
+        new_children = (html_element **)malloc(new_capacity * sizeof(html_element *));
+        if (new_children)
         {
-            free(element->content);
-            free(element->tagname);
-            free(element);
-            return NULL;
+            memcpy(new_children, element->children, element->children_count * sizeof(html_element *));
+            element->flags |= HTML_ELEMENT_OWNS_CHILDREN;
         }
-
-        element->id = html_extract_id(attributes);
     }
 
-    element->children_capacity = 4;
-    element->children = (html_element **)malloc(element->children_capacity * sizeof(html_element *));
-    if (!element->children)
+    if (!new_children)
     {
-        free(element->id);
-        free(element->attributes);
-        free(element->content);
-        free(element->tagname);
-        free(element);
-        html_set_error("Memory allocation failed for children array");
-        return NULL;
+        html_set_error_code(HTML_ERROR_MEMORY, "Memory allocation failed for resizing children array");
+        return 0;
     }
 
-    memset(element->children, 0, element->children_capacity * sizeof(html_element *));
+    for (int i = element->children_count; i < new_capacity; i++)
+    {
+        new_children[i] = NULL;
+    }
 
-    return element;
+    element->children = new_children;
+    element->children_capacity = new_capacity;
+    return 1;
 }
 
 html_element *html_add_child(html_context *ctx, html_element *parent, const char *tagname, const char *attributes, const char *content)
@@ -74,161 +181,156 @@ html_element *html_add_child(html_context *ctx, html_element *parent, const char
     if (!ctx || !parent || !tagname)
         return NULL;
 
-    if (!html_is_valid_child(parent->tagname, tagname))
+    int tag = html_tag_intern(tagname);
+    if (tag < 0)
+        return NULL;
+
+    return html_add_child_tag(ctx, parent, tag, attributes, content);
+}
+
+html_element *html_add_child_tag(html_context *ctx, html_element *parent, int tag, const char *attributes, const char *content)
+{
+    if (!ctx || !parent)
+        return NULL;
+
+    if (!html_tag_is_valid_child(parent->tag, tag))
     {
-        html_set_error("Invalid child tag '%s' for parent '%s'", tagname, parent->tagname);
+        html_set_error_tags(HTML_ERROR_INVALID_CHILD, "Invalid child tag '%s' for parent '%s'", tag, parent->tag);
         return NULL;
     }
 
-    html_element *child = html_create_element(tagname, attributes, content);
+    html_element *child = html_create_element_tag(ctx, tag, attributes, content);
     if (!child)
         return NULL;
 
     child->parent = parent;
 
-    if (parent->children_count >= parent->children_capacity)
+    if (!html_element_reserve_children(parent, parent->children_count + 1))
     {
-        int new_capacity = parent->children_capacity * 2;
-        html_element **new_children = (html_element **)realloc(parent->children,
-                                                               new_capacity * sizeof(html_element *));
-
-        if (!new_children)
-        {
-            html_free_element(child);
-            html_set_error("Memory allocation failed for resizing children array");
-            return NULL;
-        }
-
-        for (int i = parent->children_capacity; i < new_capacity; i++)
-        {
-            new_children[i] = NULL;
-        }
-
-        parent->children = new_children;
-        parent->children_capacity = new_capacity;
+        html_free_element(child);
+        return NULL;
     }
 
     parent->children[parent->children_count++] = child;
+    html_mark_dirty(parent);
 
     if (child->id)
     {
         html_register_element_by_id(ctx, child);
     }
 
+    html_index_element(ctx, child);
+
     return child;
 }
 
-void html_free_element(html_element *element)
+static void html_release_element(html_element *element)
 {
-    if (!element)
-        return;
+    if (element->flags & HTML_ELEMENT_ID_INDEXED)
+        html_unregister_element_by_id(element->owner, element);
 
-    for (int i = 0; i < element->children_count; i++)
-    {
-        html_free_element(element->children[i]);
-    }
+    if (element->flags & HTML_ELEMENT_INDEXED)
+        html_unindex_element(element->owner, element);
 
-    free(element->children);
+    html_element_release(element, element->children, HTML_ELEMENT_OWNS_CHILDREN);
+    html_element_release(element, element->content, HTML_ELEMENT_OWNS_CONTENT);
+    html_free_attributes(element);
 
-    free(element->id);
-    free(element->tagname);
-    free(element->content);
-    free(element->attributes);
-
-    free(element);
+    if (element->flags & HTML_ELEMENT_OWNS_SELF)
+        free(element);
 }
 
-int html_set_element_content(html_element *element, const char *content)
+static void html_destroy_element(html_element *element)
 {
-    if (!element)
-        return -1;
-
-    free(element->content);
-
-    if (content)
+    // post-order walk over the parent links: each child is popped off its
+    // parent's array before descending, so no stack is needed at any depth
+    html_element *node = element;
+    while (node)
     {
-        element->content = html_strdup(content);
-        if (!element->content)
+        if (node->children_count > 0)
         {
-            html_set_error("Memory allocation failed for element content");
-            return -1;
+            node = node->children[--node->children_count];
+            continue;
         }
-    }
-    else
-    {
-        element->content = NULL;
-    }
 
-    return 0;
+        html_element *parent = node == element ? NULL : node->parent;
+        html_release_element(node);
+        node = parent;
+    }
 }
 
-int html_set_element_attribute(html_element *element, const char *name, const char *value)
+void html_mark_dirty(html_element *element)
 {
-    if (!element || !name || !value)
-        return -1;
-
-    char *new_attributes = html_add_attribute(element->attributes, name, value);
-    if (!new_attributes)
+    // dirty elements always have dirty ancestors, so the walk can stop early
+    while (element && !(element->flags & HTML_ELEMENT_DIRTY))
     {
-        return -1;
+        element->flags |= HTML_ELEMENT_DIRTY;
+        element = element->parent;
     }
+}
 
-    free(element->attributes);
-
-    element->attributes = new_attributes;
+void html_free_element(html_element *element)
+{
+    if (!element)
+        return;
 
-    if (strcmp(name, "id") == 0)
+    html_element *parent = element->parent;
+    if (parent)
     {
-        free(element->id);
-        element->id = html_strdup(value);
-        if (!element->id)
+        html_mark_dirty(parent);
+        for (int i = parent->children_count - 1; i >= 0; i--)
         {
-            html_set_error("Memory allocation failed for element ID");
-            return -1;
+            if (parent->children[i] == element)
+            {
+                memmove(&parent->children[i], &parent->children[i + 1],
+                        (parent->children_count - i - 1) * sizeof(html_element *));
+                parent->children[--parent->children_count] = NULL;
+                break;
+            }
         }
     }
 
-    return 0;
+    html_destroy_element(element);
 }
 
-int html_add_class(html_element *element, const char *classname)
+int html_set_element_content(html_element *element, const char *content)
 {
-    if (!element || !classname)
+    if (!element)
         return -1;
 
-    char *current_class = html_extract_attribute(element->attributes, "class");
+    html_mark_dirty(element);
+    html_element_release(element, element->content, HTML_ELEMENT_OWNS_CONTENT);
 
-    char *new_class = NULL;
-    if (current_class)
+    if (content)
     {
-
-        int total_len = strlen(current_class) + strlen(classname) + 2;
-        new_class = (char *)malloc(total_len);
-        if (!new_class)
+        element->content = html_element_strdup(element, content, HTML_ELEMENT_OWNS_CONTENT);
+        if (!element->content)
         {
-            free(current_class);
-            html_set_error("Memory allocation failed for class attribute");
+            html_set_error_code(HTML_ERROR_MEMORY, "Memory allocation failed for element content");
             return -1;
         }
-
-        sprintf(new_class, "%s %s", current_class, classname);
-        free(current_class);
     }
     else
     {
-
-        new_class = html_strdup(classname);
-        if (!new_class)
-        {
-            html_set_error("Memory allocation failed for class attribute");
-            return -1;
-        }
+        element->content = NULL;
     }
 
-    int result = html_set_element_attribute(element, "class", new_class);
-    free(new_class);
+    return 0;
+}
+
+int html_set_element_escape(html_element *element, int escape)
+{
+    if (!element)
+        return -1;
+
+    unsigned int flags = escape ? element->flags | HTML_ELEMENT_ESCAPE : element->flags & ~HTML_ELEMENT_ESCAPE;
+    if (flags != element->flags)
+    {
+        element->flags = flags;
+        html_mark_dirty(element);
+    }
 
-    return result;
+    return 0;
 }
 
 int html_add_div(html_context *ctx, const char *attributes, const char *content)
@@ -236,7 +338,7 @@ int html_add_div(html_context *ctx, const char *attributes, const char *content)
     if (!ctx || !ctx->current)
         return -1;
 
-    html_element *div = html_add_child(ctx, ctx->current, "div", attributes, content);
+    html_element *div = html_add_child_tag(ctx, ctx->current, HTML_TAG_DIV, attributes, content);
     return div ? 0 : -1;
 }
 
@@ -245,7 +347,7 @@ int html_add_paragraph(html_context *ctx, const char *attributes, const char *co
     if (!ctx || !ctx->current)
         return -1;
 
-    html_element *p = html_add_child(ctx, ctx->current, "p", attributes, content);
+    html_element *p = html_add_child_tag(ctx, ctx->current, HTML_TAG_P, attributes, content);
     return p ? 0 : -1;
 }
 
@@ -254,11 +356,7 @@ int html_add_heading(html_context *ctx, int level, const char *content, const ch
     if (!ctx || !ctx->current || level < 1 || level > 6)
         return -1;
 
-    char tagname[4] = "h";
-    tagname[1] = '0' + level;
-    tagname[2] = '\0';
-
-    html_element *heading = html_add_child(ctx, ctx->current, tagname, attributes, content);
+    html_element *heading = html_add_child_tag(ctx, ctx->current, HTML_TAG_H1 + level - 1, attributes, content);
     return heading ? 0 : -1;
 }
 
@@ -267,7 +365,7 @@ int html_begin_section(html_context *ctx, const char *attributes)
     if (!ctx || !ctx->current)
         return -1;
 
-    html_element *section = html_add_child(ctx, ctx->current, "div", attributes, NULL);
+    html_element *section = html_add_child_tag(ctx, ctx->current, HTML_TAG_DIV, attributes, NULL);
     if (!section)
         return -1;
 
@@ -280,8 +378,9 @@ int html_end_section(html_context *ctx)
     if (!ctx || !ctx->current || !ctx->current->parent)
         return -1;
 
-    ctx->current = ctx->current->parent;
-    return 0;
+    html_element *closed = ctx->current;
+    ctx->current = closed->parent;
+    return html_stream_element(ctx, closed) ? 0 : -1;
 }
 
 int html_add_image(html_context *ctx, const char *src, const char *alt, const char *attributes)
@@ -311,7 +410,7 @@ int html_add_image(html_context *ctx, const char *src, const char *alt, const ch
         if (!temp)
         {
             free(combined_attrs);
-            html_set_error("Memory allocation failed for combined attributes");
+            html_set_error_code(HTML_ERROR_MEMORY, "Memory allocation failed for combined attributes");
             return -1;
         }
         sprintf(temp, "%s %s", combined_attrs, attributes);
@@ -319,7 +418,7 @@ int html_add_image(html_context *ctx, const char *src, const char *alt, const ch
         combined_attrs = temp;
     }
 
-    html_element *img = html_add_child(ctx, ctx->current, "img", combined_attrs, NULL);
+    html_element *img = html_add_child_tag(ctx, ctx->current, HTML_TAG_IMG, combined_attrs, NULL);
     free(combined_attrs);
 
     return img ? 0 : -1;
@@ -340,7 +439,7 @@ int html_add_anchor(html_context *ctx, const char *href, const char *content, co
         if (!temp)
         {
             free(combined_attrs);
-            html_set_error("Memory allocation failed for combined attributes");
+            html_set_error_code(HTML_ERROR_MEMORY, "Memory allocation failed for combined attributes");
             return -1;
         }
         sprintf(temp, "%s %s", combined_attrs, attributes);
@@ -348,7 +447,7 @@ int html_add_anchor(html_context *ctx, const char *href, const char *content, co
         combined_attrs = temp;
     }
 
-    html_element *anchor = html_add_child(ctx, ctx->current, "a", combined_attrs, content);
+    html_element *anchor = html_add_child_tag(ctx, ctx->current, HTML_TAG_A, combined_attrs, content);
     free(combined_attrs);
 
     return anchor ? 0 : -1;
@@ -359,7 +458,7 @@ int html_begin_unordered_list(html_context *ctx, const char *attributes)
     if (!ctx || !ctx->current)
         return -1;
 
-    html_element *ul = html_add_child(ctx, ctx->current, "ul", attributes, NULL);
+    html_element *ul = html_add_child_tag(ctx, ctx->current, HTML_TAG_UL, attributes, NULL);
     if (!ul)
         return -1;
 
@@ -372,7 +471,7 @@ int html_begin_ordered_list(html_context *ctx, const char *attributes)
     if (!ctx || !ctx->current)
         return -1;
 
-    html_element *ol = html_add_child(ctx, ctx->current, "ol", attributes, NULL);
+    html_element *ol = html_add_child_tag(ctx, ctx->current, HTML_TAG_OL, attributes, NULL);
     if (!ol)
         return -1;
 
@@ -385,14 +484,15 @@ int html_end_list(html_context *ctx)
     if (!ctx || !ctx->current || !ctx->current->parent)
         return -1;
 
-    if (strcmp(ctx->current->tagname, "ul") != 0 && strcmp(ctx->current->tagname, "ol") != 0)
+    if (ctx->current->tag != HTML_TAG_UL && ctx->current->tag != HTML_TAG_OL)
     {
-        html_set_error("Current element is not a list");
+        html_set_error_code(HTML_ERROR_INVALID_STATE, "Current element is not a list");
         return -1;
     }
 
-    ctx->current = ctx->current->parent;
-    return 0;
+    html_element *closed = ctx->current;
+    ctx->current = closed->parent;
+    return html_stream_element(ctx, closed) ? 0 : -1;
 }
 
 int html_add_list_item(html_context *ctx, const char *content, const char *attributes)
@@ -400,13 +500,13 @@ int html_add_list_item(html_context *ctx, const char *content, const char *attri
     if (!ctx || !ctx->current)
         return -1;
 
-    if (strcmp(ctx->current->tagname, "ul") != 0 && strcmp(ctx->current->tagname, "ol") != 0)
+    if (ctx->current->tag != HTML_TAG_UL && ctx->current->tag != HTML_TAG_OL)
     {
-        html_set_error("Current element is not a list");
+        html_set_error_code(HTML_ERROR_INVALID_STATE, "Current element is not a list");
         return -1;
     }
 
-    html_element *li = html_add_child(ctx, ctx->current, "li", attributes, content);
+    html_element *li = html_add_child_tag(ctx, ctx->current, HTML_TAG_LI, attributes, content);
     return li ? 0 : -1;
 }
 
@@ -415,7 +515,7 @@ int html_begin_table(html_context *ctx, const char *attributes)
     if (!ctx || !ctx->current)
         return -1;
 
-    html_element *table = html_add_child(ctx, ctx->current, "table", attributes, NULL);
+    html_element *table = html_add_child_tag(ctx, ctx->current, HTML_TAG_TABLE, attributes, NULL);
     if (!table)
         return -1;
 
@@ -428,14 +528,15 @@ int html_end_table(html_context *ctx)
     if (!ctx || !ctx->current || !ctx->current->parent)
         return -1;
 
-    if (strcmp(ctx->current->tagname, "table") != 0)
+    if (ctx->current->tag != HTML_TAG_TABLE)
     {
-        html_set_error("Current element is not a table");
+        html_set_error_code(HTML_ERROR_INVALID_STATE, "Current element is not a table");
         return -1;
     }
 
-    ctx->current = ctx->current->parent;
-    return 0;
+    html_element *closed = ctx->current;
+    ctx->current = closed->parent;
+    return html_stream_element(ctx, closed) ? 0 : -1;
 }
 
 int html_begin_table_row(html_context *ctx, const char *attributes)
@@ -443,16 +544,16 @@ int html_begin_table_row(html_context *ctx, const char *attributes)
     if (!ctx || !ctx->current)
         return -1;
 
-    if (strcmp(ctx->current->tagname, "table") != 0 &&
-        strcmp(ctx->current->tagname, "tbody") != 0 &&
-        strcmp(ctx->current->tagname, "thead") != 0 &&
-        strcmp(ctx->current->tagname, "tfoot") != 0)
+    if (ctx->current->tag != HTML_TAG_TABLE &&
+        ctx->current->tag != HTML_TAG_TBODY &&
+        ctx->current->tag != HTML_TAG_THEAD &&
+        ctx->current->tag != HTML_TAG_TFOOT)
     {
-        html_set_error("Current element cannot contain table rows");
+        html_set_error_code(HTML_ERROR_INVALID_STATE, "Current element cannot contain table rows");
         return -1;
     }
 
-    html_element *tr = html_add_child(ctx, ctx->current, "tr", attributes, NULL);
+    html_element *tr = html_add_child_tag(ctx, ctx->current, HTML_TAG_TR, attributes, NULL);
     if (!tr)
         return -1;
 
@@ -465,14 +566,15 @@ int html_end_table_row(html_context *ctx)
     if (!ctx || !ctx->current || !ctx->current->parent)
         return -1;
 
-    if (strcmp(ctx->current->tagname, "tr") != 0)
+    if (ctx->current->tag != HTML_TAG_TR)
     {
-        html_set_error("Current element is not a table row");
+        html_set_error_code(HTML_ERROR_INVALID_STATE, "Current element is not a table row");
         return -1;
     }
 
-    ctx->current = ctx->current->parent;
-    return 0;
+    html_element *closed = ctx->current;
+    ctx->current = closed->parent;
+    return html_stream_element(ctx, closed) ? 0 : -1;
 }
 
 int html_add_table_cell(html_context *ctx, const char *content, const char *attributes, int is_header)
@@ -480,14 +582,13 @@ int html_add_table_cell(html_context *ctx, const char *content, const char *attr
     if (!ctx || !ctx->current)
         return -1;
 
-    if (strcmp(ctx->current->tagname, "tr") != 0)
+    if (ctx->current->tag != HTML_TAG_TR)
     {
-        html_set_error("Current element is not a table row");
+        html_set_error_code(HTML_ERROR_INVALID_STATE, "Current element is not a table row");
         return -1;
     }
 
-    const char *tagname = is_header ? "th" : "td";
-    html_element *cell = html_add_child(ctx, ctx->current, tagname, attributes, content);
+    html_element *cell = html_add_child_tag(ctx, ctx->current, is_header ? HTML_TAG_TH : HTML_TAG_TD, attributes, content);
 
     return cell ? 0 : -1;
 }
@@ -513,7 +614,7 @@ int html_add_form(html_context *ctx, const char *action, const char *method, con
         if (!temp)
         {
             free(combined_attrs);
-            html_set_error("Memory allocation failed for combined attributes");
+            html_set_error_code(HTML_ERROR_MEMORY, "Memory allocation failed for combined attributes");
             return -1;
         }
         sprintf(temp, "%s %s", combined_attrs, attributes);
@@ -521,7 +622,7 @@ int html_add_form(html_context *ctx, const char *action, const char *method, con
         combined_attrs = temp;
     }
 
-    html_element *form = html_add_child(ctx, ctx->current, "form", combined_attrs, NULL);
+    html_element *form = html_add_child_tag(ctx, ctx->current, HTML_TAG_FORM, combined_attrs, NULL);
     free(combined_attrs);
 
     if (!form)
@@ -536,14 +637,15 @@ int html_end_form(html_context *ctx)
     if (!ctx || !ctx->current || !ctx->current->parent)
         return -1;
 
-    if (strcmp(ctx->current->tagname, "form") != 0)
+    if (ctx->current->tag != HTML_TAG_FORM)
     {
-        html_set_error("Current element is not a form");
+        html_set_error_code(HTML_ERROR_INVALID_STATE, "Current element is not a form");
         return -1;
     }
 
-    ctx->current = ctx->current->parent;
-    return 0;
+    html_element *closed = ctx->current;
+    ctx->current = closed->parent;
+    return html_stream_element(ctx, closed) ? 0 : -1;
 }
 
 int html_add_input(html_context *ctx, const char *type, const char *name, const char *value, const char *attributes)
@@ -579,7 +681,7 @@ int html_add_input(html_context *ctx, const char *type, const char *name, const
         if (!temp)
         {
             free(combined_attrs);
-            html_set_error("Memory allocation failed for combined attributes");
+            html_set_error_code(HTML_ERROR_MEMORY, "Memory allocation failed for combined attributes");
             return -1;
         }
         sprintf(temp, "%s %s", combined_attrs, attributes);
@@ -587,7 +689,7 @@ int html_add_input(html_context *ctx, const char *type, const char *name, const
         combined_attrs = temp;
     }
 
-    html_element *input = html_add_child(ctx, ctx->current, "input", combined_attrs, NULL);
+    html_element *input = html_add_child_tag(ctx, ctx->current, HTML_TAG_INPUT, combined_attrs, NULL);
     free(combined_attrs);
 
     return input ? 0 : -1;
@@ -615,7 +717,7 @@ int html_add_button(html_context *ctx, const char *type, const char *content, co
             if (!temp)
             {
                 free(combined_attrs);
-                html_set_error("Memory allocation failed for combined attributes");
+                html_set_error_code(HTML_ERROR_MEMORY, "Memory allocation failed for combined attributes");
                 return -1;
             }
             sprintf(temp, "%s %s", combined_attrs, attributes);
@@ -630,7 +732,7 @@ int html_add_button(html_context *ctx, const char *type, const char *content, co
         }
     }
 
-    html_element *button = html_add_child(ctx, ctx->current, "button", combined_attrs, content);
+    html_element *button = html_add_child_tag(ctx, ctx->current, HTML_TAG_BUTTON, combined_attrs, content);
     free(combined_attrs);
 
     return button ? 0 : -1;
@@ -0,0 +1,139 @@
+#include "HTML.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__)))
+#include <immintrin.h>
+#define HTML_ESCAPE_SIMD 1
+#endif
+
+// one byte per character: the length of its entity minus one, or 0 when it is kept
+static const unsigned char html_escape_growth[256] = {
+    ['&'] = 4,
+    ['<'] = 3,
+    ['>'] = 3,
+    ['"'] = 5,
+    ['\''] = 4,
+};
+
+static size_t html_escape_scan_scalar(const char *data, size_t i, size_t len)
+{
+    while (i < len && !html_escape_growth[(unsigned char)data[i]])
+        i++;
+    return i;
+}
+
+#ifdef HTML_ESCAPE_SIMD
+// '<' and '>' differ only in bit 1 and '&' and '\'' only in bit 0, so three
+// compares cover all five characters
+static size_t html_escape_scan_sse2(const char *data, size_t i, size_t len)
+{
+    const __m128i lt_gt = _mm_set1_epi8('>');
+    const __m128i amp_apos = _mm_set1_epi8('\'');
+    const __m128i quot = _mm_set1_epi8('"');
+    const __m128i bit0 = _mm_set1_epi8(1);
+    const __m128i bit1 = _mm_set1_epi8(2);
+
+    for (; i + 16 <= len; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(data + i));
+        __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(_mm_or_si128(v, bit1), lt_gt),
+                                    _mm_or_si128(_mm_cmpeq_epi8(_mm_or_si128(v, bit0), amp_apos),
+                                                 _mm_cmpeq_epi8(v, quot)));
+        int mask = _mm_movemask_epi8(hits);
+        if (mask)
+            return i + (size_t)__builtin_ctz((unsigned int)mask);
+    }
+
+    return html_escape_scan_scalar(data, i, len);
+}
+
+__attribute__((target("avx2"))) static size_t html_escape_scan_avx2(const char *data, size_t i, size_t len)
+{
+    const __m256i lt_gt = _mm256_set1_epi8('>');
+    const __m256i amp_apos = _mm256_set1_epi8('\'');
+    const __m256i quot = _mm256_set1_epi8('"');
+    const __m256i bit0 = _mm256_set1_epi8(1);
+    const __m256i bit1 = _mm256_set1_epi8(2);
+
+    for (; i + 32 <= len; i += 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(data + i));
+        __m256i hits = _mm256_or_si256(_mm256_cmpeq_epi8(_mm256_or_si256(v, bit1), lt_gt),
+                                       _mm256_or_si256(_mm256_cmpeq_epi8(_mm256_or_si256(v, bit0), amp_apos),
+                                                       _mm256_cmpeq_epi8(v, quot)));
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(hits);
+        if (mask)
+            return i + (size_t)__builtin_ctz(mask);
+    }
+
+    return html_escape_scan_sse2(data, i, len);
+}
+#endif
+
+size_t html_escape_scan(const char *data, size_t len)
+{
+#ifdef HTML_ESCAPE_SIMD
+    // short text is not worth a vector setup
+    if (len >= 32 && __builtin_cpu_supports("avx2"))
+        return html_escape_scan_avx2(data, 0, len);
+    if (len >= 16)
+        return html_escape_scan_sse2(data, 0, len);
+#endif
+    return html_escape_scan_scalar(data, 0, len);
+}
+
+size_t html_escaped_length(const char *data, size_t len)
+{
+    size_t size = len;
+    size_t i = html_escape_scan(data, len);
+
+    while (i < len)
+    {
+        size += html_escape_growth[(unsigned char)data[i]];
+        i++;
+        i += html_escape_scan(data + i, len - i);
+    }
+
+    return size;
+}
+
+static const char *html_escape_entity(char c)
+{
+    switch (c)
+    {
+    case '&':
+        return "&amp;";
+    case '<':
+        return "&lt;";
+    case '>':
+        return "&gt;";
+    case '"':
+        return "&quot;";
+    default:
+        return "&#39;";
+    }
+}
+
+int html_writer_append_escaped(html_writer *writer, const char *data, size_t len)
+{
+    while (len > 0)
+    {
+        size_t run = html_escape_scan(data, len);
+        if (run > 0 && !html_writer_append_ref(writer, data, run))
+            return 0;
+
+        if (run == len)
+            break;
+
+        char c = data[run];
+        if (!html_writer_append(writer, html_escape_entity(c), html_escape_growth[(unsigned char)c] + 1))
+            return 0;
+
+        data += run + 1;
+        len -= run + 1;
+    }
+
+    return 1;
+}
@@ -0,0 +1,468 @@
+#include "HTML.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HTML_FRAGMENT_NONE ((size_t)-1)
+
+typedef struct
+{
+    const char *name;
+    size_t value;
+    unsigned int length;
+    unsigned char quote;
+} html_fragment_attribute;
+
+// nodes are stored breadth first, so the children of a node are the run
+// [first_child, first_child + children_count) of the node array
+typedef struct
+{
+    int tag;
+    unsigned int flags;
+    int parent;
+    size_t content;
+    int first_attribute;
+    int attribute_count;
+    int first_child;
+    int children_count;
+    int id_attribute;
+} html_fragment_node;
+
+struct html_fragment
+{
+    html_fragment_node *nodes;
+    int node_count;
+    html_fragment_attribute *attributes;
+    int attribute_count;
+    char *strings;
+    size_t strings_length;
+    size_t id_bytes;
+    int id_count;
+};
+
+static size_t html_fragment_add_string(html_fragment *frag, const char *str, size_t len)
+{
+    size_t offset = frag->strings_length;
+    memcpy(frag->strings + offset, str, len);
+    frag->strings[offset + len] = '\0';
+    frag->strings_length += len + 1;
+    return offset;
+}
+
+html_fragment *html_fragment_create(const html_element *root)
+{
+    if (!root)
+    {
+        html_set_error_code(HTML_ERROR_INVALID_ARGUMENT, "Fragment root cannot be NULL");
+        return NULL;
+    }
+
+    // breadth-first queue of the source elements; it becomes the node order
+    int capacity = 64;
+    int count = 1;
+    const html_element **queue = (const html_element **)malloc(capacity * sizeof(html_element *));
+    if (!queue)
+    {
+        html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for fragment");
+        return NULL;
+    }
+    queue[0] = root;
+
+    int attribute_count = 0;
+    size_t strings_length = 0;
+    for (int i = 0; i < count; i++)
+    {
+        const html_element *element = queue[i];
+        if (element->content)
+            strings_length += strlen(element->content) + 1;
+
+        attribute_count += element->attribute_count;
+        for (int a = 0; a < element->attribute_count; a++)
+        {
+            if (element->attributes[a].value)
+                strings_length += element->attributes[a].length + 1;
+        }
+
+        if (count + element->children_count > capacity)
+        {
+            while (count + element->children_count > capacity)
+                capacity *= 2;
+
+            const html_element **grown = (const html_element **)realloc(queue, capacity * sizeof(html_element *));
+            if (!grown)
+            {
+                free(queue);
+                html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for fragment");
+                return NULL;
+            }
+            queue = grown;
+        }
+
+        for (int c = 0; c < element->children_count; c++)
+            queue[count++] = element->children[c];
+    }
+
+    html_fragment *frag = (html_fragment *)calloc(1, sizeof(html_fragment));
+    if (frag)
+    {
+        frag->nodes = (html_fragment_node *)malloc(count * sizeof(html_fragment_node));
+        frag->attributes = (html_fragment_attribute *)malloc((attribute_count ? attribute_count : 1) *
+                                                             sizeof(html_fragment_attribute));
+        frag->strings = (char *)malloc(strings_length ? strings_length : 1);
+    }
+
+    if (!frag || !frag->nodes || !frag->attributes || !frag->strings)
+    {
+        free(queue);
+        html_fragment_free(frag);
+        html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for fragment");
+        return NULL;
+    }
+
+    int next_child = 1;
+    for (int i = 0; i < count; i++)
+    {
+        const html_element *element = queue[i];
+        html_fragment_node *node = &frag->nodes[i];
+
+        node->tag = element->tag;
+        node->flags = element->flags & HTML_ELEMENT_ESCAPE;
+        node->content = element->content ? html_fragment_add_string(frag, element->content, strlen(element->content))
+                                         : HTML_FRAGMENT_NONE;
+        node->first_attribute = frag->attribute_count;
+        node->attribute_count = element->attribute_count;
+        node->first_child = next_child;
+        node->children_count = element->children_count;
+        node->id_attribute = -1;
+
+        for (int c = 0; c < element->children_count; c++)
+            frag->nodes[next_child + c].parent = i;
+        next_child += element->children_count;
+
+        for (int a = 0; a < element->attribute_count; a++)
+        {
+            const html_attribute *attr = &element->attributes[a];
+            html_fragment_attribute *copy = &frag->attributes[frag->attribute_count];
+
+            copy->name = attr->name;
+            copy->quote = attr->quote;
+            copy->length = attr->length;
+            copy->value = attr->value ? html_fragment_add_string(frag, attr->value, attr->length) : HTML_FRAGMENT_NONE;
+
+            if (element->id && attr->value == element->id)
+            {
+                node->id_attribute = frag->attribute_count;
+                frag->id_bytes += attr->length;
+                frag->id_count++;
+            }
+            frag->attribute_count++;
+        }
+    }
+
+    // every other node got its parent while its parent was being copied
+    frag->nodes[0].parent = -1;
+    frag->node_count = count;
+    free(queue);
+    return frag;
+}
+
+static const char *html_fragment_node_id(const html_fragment *frag, const html_fragment_node *node)
+{
+    if (node->id_attribute < 0)
+        return NULL;
+    return frag->strings + frag->attributes[node->id_attribute].value;
+}
+
+static const char *html_fragment_override_value(const html_fragment_overrides *overrides, const char *id,
+                                                const char *name)
+{
+    if (!overrides || !id)
+        return NULL;
+
+    for (int i = 0; i < overrides->count; i++)
+    {
+        const html_fragment_override *item = &overrides->items[i];
+        if (strcmp(item->id, id) != 0)
+            continue;
+
+        if (name ? item->name && strcmp(item->name, name) == 0 : !item->name)
+            return item->value;
+    }
+
+    return NULL;
+}
+
+static int html_fragment_has_attribute(const html_fragment *frag, const html_fragment_node *node, const char *name)
+{
+    for (int a = 0; a < node->attribute_count; a++)
+    {
+        if (strcmp(frag->attributes[node->first_attribute + a].name, name) == 0)
+            return 1;
+    }
+    return 0;
+}
+
+static int html_fragment_find_id(const html_fragment *frag, const char *id)
+{
+    for (int i = 0; i < frag->node_count; i++)
+    {
+        const char *node_id = html_fragment_node_id(frag, &frag->nodes[i]);
+        if (node_id && strcmp(node_id, id) == 0)
+            return i;
+    }
+    return -1;
+}
+
+// whether an ID the instance would get is already registered in the context
+static int html_fragment_ids_taken(const html_context *ctx, const html_fragment *frag,
+                                   const html_fragment_overrides *overrides, const char *suffix, size_t suffix_len,
+                                   int report)
+{
+    if (!ctx->element_map)
+        return 0;
+
+    char stack_id[128];
+    for (int i = 0; i < frag->node_count; i++)
+    {
+        const char *id = html_fragment_node_id(frag, &frag->nodes[i]);
+        if (!id)
+            continue;
+
+        const char *candidate = html_fragment_override_value(overrides, id, "id");
+        char *built = NULL;
+        if (!candidate)
+        {
+            size_t len = strlen(id);
+            built = len + suffix_len < sizeof(stack_id) ? stack_id : (char *)malloc(len + suffix_len + 1);
+            if (!built)
+            {
+                html_set_error_code(HTML_ERROR_MEMORY, "Memory allocation failed for HTML element");
+                return -1;
+            }
+            memcpy(built, id, len);
+            memcpy(built + len, suffix, suffix_len + 1);
+            candidate = built;
+        }
+
+        int taken = html_table_get(ctx->element_map, candidate) != NULL;
+        if (taken && report)
+            html_set_error_ex(HTML_ERROR_DUPLICATE_ID, "Duplicate element ID: '%s'", candidate);
+
+        if (built != stack_id)
+            free(built);
+        if (taken)
+            return 1;
+    }
+
+    return 0;
+}
+
+static char *html_fragment_put(char **extra, const char *str, size_t len)
+{
+    char *copy = *extra;
+    memcpy(copy, str, len);
+    copy[len] = '\0';
+    *extra += len + 1;
+    return copy;
+}
+
+html_element *html_fragment_instantiate(html_context *ctx, html_element *parent, html_fragment *frag,
+                                        const html_fragment_overrides *overrides)
+{
+    if (!ctx || !parent || !frag)
+        return NULL;
+
+    const html_fragment_node *nodes = frag->nodes;
+    if (!html_tag_is_valid_child(parent->tag, nodes[0].tag))
+    {
+        html_set_error_tags(HTML_ERROR_INVALID_CHILD, "Invalid child tag '%s' for parent '%s'", nodes[0].tag,
+                            parent->tag);
+        return NULL;
+    }
+
+    size_t extra_bytes = 0;
+    for (int i = 0; overrides && i < overrides->count; i++)
+    {
+        const html_fragment_override *item = &overrides->items[i];
+        if (!item->id || !item->value || html_fragment_find_id(frag, item->id) < 0)
+        {
+            html_set_error_ex(HTML_ERROR_NOT_FOUND, "Fragment has no element with ID '%s'",
+                              item->id ? item->id : "");
+            return NULL;
+        }
+        extra_bytes += strlen(item->value) + 1;
+    }
+
+    char suffix_buffer[16];
+    const char *suffix = overrides ? overrides->id_suffix : NULL;
+    size_t suffix_len = 0;
+    int taken = 0;
+    if (suffix)
+    {
+        suffix_len = strlen(suffix);
+        taken = html_fragment_ids_taken(ctx, frag, overrides, suffix, suffix_len, 1);
+    }
+    else if (frag->id_count > 0)
+    {
+        // every instance gets its own IDs unless the caller picks a suffix; the
+        // count lives in the context so a fragment can be shared across threads,
+        // and numbers already taken by elements added some other way are skipped
+        suffix = suffix_buffer;
+        do
+        {
+            suffix_len = (size_t)snprintf(suffix_buffer, sizeof(suffix_buffer), "-%u", ++ctx->fragment_instances);
+            taken = html_fragment_ids_taken(ctx, frag, overrides, suffix, suffix_len, 0);
+        } while (taken > 0);
+    }
+    if (taken)
+        return NULL;
+
+    extra_bytes += frag->id_bytes + frag->id_count * (suffix_len + 1);
+
+    // elements, attribute arrays, children arrays and strings share one block
+    size_t element_bytes = frag->node_count * sizeof(html_element);
+    size_t attribute_bytes = frag->attribute_count * sizeof(html_attribute);
+    size_t children_bytes = (frag->node_count - 1) * sizeof(html_element *);
+    size_t size = element_bytes + attribute_bytes + children_bytes + frag->strings_length + extra_bytes;
+
+    int in_arena = (ctx->flags & HTML_CONTEXT_ARENA) && ctx->arena;
+    char *block = in_arena ? (char *)html_arena_alloc(ctx->arena, size) : (char *)malloc(size);
+    if (!block)
+    {
+        html_set_error_code(HTML_ERROR_MEMORY, "Memory allocation failed for HTML element");
+        return NULL;
+    }
+
+    html_element *elements = (html_element *)block;
+    html_attribute *attributes = (html_attribute *)(block + element_bytes);
+    html_element **children = (html_element **)(block + element_bytes + attribute_bytes);
+    char *strings = block + element_bytes + attribute_bytes + children_bytes;
+    char *extra = strings + frag->strings_length;
+
+    memcpy(strings, frag->strings, frag->strings_length);
+
+    for (int i = 0; i < frag->node_count; i++)
+    {
+        const html_fragment_node *node = &nodes[i];
+        const char *id = html_fragment_node_id(frag, node);
+        html_element *element = &elements[i];
+
+        memset(element, 0, sizeof(html_element));
+        element->owner = ctx;
+        element->flags = HTML_ELEMENT_DIRTY | node->flags;
+        element->tag = node->tag;
+        element->tagname = html_tag_name(node->tag);
+        element->parent = node->parent < 0 ? parent : &elements[node->parent];
+
+        const char *content = html_fragment_override_value(overrides, id, NULL);
+        if (content)
+            element->content = html_fragment_put(&extra, content, strlen(content));
+        else if (node->content != HTML_FRAGMENT_NONE)
+            element->content = strings + node->content;
+
+        if (node->attribute_count > 0)
+        {
+            element->attributes = &attributes[node->first_attribute];
+            element->attribute_count = node->attribute_count;
+            element->attribute_capacity = node->attribute_count;
+        }
+
+        for (int a = 0; a < node->attribute_count; a++)
+        {
+            const html_fragment_attribute *source = &frag->attributes[node->first_attribute + a];
+            html_attribute *attr = &element->attributes[a];
+            const char *value = html_fragment_override_value(overrides, id, source->name);
+
+            memset(attr, 0, sizeof(html_attribute));
+            attr->name = source->name;
+            attr->quote = source->quote;
+
+            if (value)
+            {
+                attr->length = (unsigned int)strlen(value);
+                attr->value = html_fragment_put(&extra, value, attr->length);
+                if (!attr->quote || strchr(attr->value, attr->quote))
+                    attr->quote = strchr(attr->value, '"') ? '\'' : '"';
+            }
+            else if (node->first_attribute + a == node->id_attribute)
+            {
+                attr->length = source->length + (unsigned int)suffix_len;
+                attr->value = extra;
+                memcpy(extra, strings + source->value, source->length);
+                memcpy(extra + source->length, suffix, suffix_len);
+                extra[attr->length] = '\0';
+                extra += attr->length + 1;
+            }
+            else if (source->value != HTML_FRAGMENT_NONE)
+            {
+                attr->value = strings + source->value;
+                attr->length = source->length;
+            }
+            attr->capacity = attr->length;
+
+            if (node->first_attribute + a == node->id_attribute)
+                element->id = attr->value;
+        }
+
+        if (node->children_count > 0)
+        {
+            element->children = &children[node->first_child - 1];
+            element->children_count = node->children_count;
+            element->children_capacity = node->children_count;
+            for (int c = 0; c < node->children_count; c++)
+                element->children[c] = &elements[node->first_child + c];
+        }
+    }
+
+    // the root carries the block, so freeing the copy releases it in one go
+    if (!in_arena)
+        elements[0].flags |= HTML_ELEMENT_OWNS_SELF;
+
+    int registered = 0;
+    if (html_element_reserve_children(parent, parent->children_count + 1))
+    {
+        while (registered < frag->node_count &&
+               (!elements[registered].id || html_register_element_by_id(ctx, &elements[registered])))
+            registered++;
+    }
+
+    if (registered < frag->node_count)
+    {
+        while (registered-- > 0)
+            html_unregister_element_by_id(ctx, &elements[registered]);
+        if (!in_arena)
+            free(block);
+        return NULL;
+    }
+
+    parent->children[parent->children_count++] = &elements[0];
+    html_mark_dirty(parent);
+
+    for (int i = 0; i < frag->node_count; i++)
+        html_index_element(ctx, &elements[i]);
+
+    // overrides of attributes the fragment lacks take the regular path
+    for (int i = 0; overrides && i < overrides->count; i++)
+    {
+        const html_fragment_override *item = &overrides->items[i];
+        if (!item->name)
+            continue;
+
+        int index = html_fragment_find_id(frag, item->id);
+        if (!html_fragment_has_attribute(frag, &nodes[index], item->name))
+            html_set_element_attribute(&elements[index], item->name, item->value);
+    }
+
+    return &elements[0];
+}
+
+void html_fragment_free(html_fragment *frag)
+{
+    if (!frag)
+        return;
+
+    free(frag->nodes);
+    free(frag->attributes);
+    free(frag->strings);
+    free(frag);
+}
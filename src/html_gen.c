@@ -6,19 +6,25 @@
 
 
 html_context *html_init_string(const char *title)
+{
+    return html_init_string_ex(title, 0);
+}
+
+html_context *html_init_string_ex(const char *title, int flags)
 {
     html_clear_error();
 
     html_context *ctx = (html_context *)malloc(sizeof(html_context));
     if (!ctx)
     {
-        html_set_error("memory allocation failed for HTML context");
+        html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for HTML context");
         return NULL;
     }
 
     memset(ctx, 0, sizeof(html_context));
     ctx->output_file = NULL;
     ctx->indent_level = 0;
+    ctx->flags = flags;
 
     if (title)
     {
@@ -47,72 +53,23 @@ html_context *html_init_string(const char *title)
         return NULL;
     }
 
-    if (!html_create_document_structure(ctx))
-    {
-        html_finalize(ctx);
-        return NULL;
-    }
-
-    return ctx;
-}
-
-char *html_render_to_string(html_context *ctx)
-{
-    html_clear_error();
-
-    if (!ctx || !ctx->root)
-    {
-        html_set_error("Invalid HTML context or root element");
-        return NULL;
-    }
-
-    FILE *temp_file = tmpfile();
-    if (!temp_file)
-    {
-        html_set_error("failed to create temporary file for rendering");
-        return NULL;
-    }
-
-    FILE *original_file = ctx->output_file;
-    ctx->output_file = temp_file;
-
-    fprintf(temp_file, "<!DOCTYPE html>\n");
-    ctx->indent_level = 0;
-    int result = html_render_element(ctx, ctx->root);
-
-    ctx->output_file = original_file;
-
-    if (result != 0)
+    if (flags & HTML_CONTEXT_ARENA)
     {
-        fclose(temp_file);
-        return NULL;
-    }
-
-    fseek(temp_file, 0, SEEK_END);
-    long size = ftell(temp_file);
-    rewind(temp_file);
-
-    char *html_string = (char *)malloc(size + 1);
-    if (!html_string)
-    {
-        fclose(temp_file);
-        html_set_error("memory allocation failed for HTML string");
-        return NULL;
+        ctx->arena = html_arena_create(HTML_ARENA_DEFAULT_BLOCK_SIZE);
+        if (!ctx->arena)
+        {
+            html_finalize(ctx);
+            return NULL;
+        }
     }
 
-    long read_size = fread(html_string, 1, size, temp_file);
-    fclose(temp_file);
-
-    if (read_size != (int)size)
+    if (!html_create_document_structure(ctx))
     {
-        free(html_string);
-        html_set_error("Failed to read rendered HTML");
+        html_finalize(ctx);
         return NULL;
     }
 
-    html_string[size] = '\0';
-
-    return html_string;
+    return ctx;
 }
 
 int html_begin_tag(html_context *ctx, const char *tagname, const char *attributes)
@@ -121,7 +78,7 @@ int html_begin_tag(html_context *ctx, const char *tagname, const char *attribute
 
     if (!ctx || !ctx->current || !tagname)
     {
-        html_set_error("Invalid parameters for beginning tag");
+        html_set_error_code(HTML_ERROR_INVALID_ARGUMENT, "Invalid parameters for beginning tag");
         return -1;
     }
 
@@ -139,12 +96,13 @@ int html_end_tag(html_context *ctx)
 
     if (!ctx || !ctx->current || !ctx->current->parent)
     {
-        html_set_error("Cannot end tag: no current element or at root level");
+        html_set_error_code(HTML_ERROR_INVALID_STATE, "Cannot end tag: no current element or at root level");
         return -1;
     }
 
-    ctx->current = ctx->current->parent;
-    return 0;
+    html_element *closed = ctx->current;
+    ctx->current = closed->parent;
+    return html_stream_element(ctx, closed) ? 0 : -1;
 }
 
 int html_add_content(html_context *ctx, const char *content)
@@ -153,7 +111,7 @@ int html_add_content(html_context *ctx, const char *content)
 
     if (!ctx || !ctx->current)
     {
-        html_set_error("Invalid HTML context or current element");
+        html_set_error_code(HTML_ERROR_INVALID_ARGUMENT, "Invalid HTML context or current element");
         return -1;
     }
 
@@ -162,27 +120,38 @@ int html_add_content(html_context *ctx, const char *content)
         return 0;
     }
 
-    if (ctx->current->content)
+    html_element *element = ctx->current;
+    html_mark_dirty(element);
+
+    if (element->content)
     {
-        char *new_content = (char *)malloc(strlen(ctx->current->content) + strlen(content) + 1);
+        char *old_content = element->content;
+        int owned = element->flags & HTML_ELEMENT_OWNS_CONTENT;
+        size_t old_len = strlen(old_content);
+        size_t add_len = strlen(content);
+
+        char *new_content = (char *)html_element_alloc(element, old_len + add_len + 1, HTML_ELEMENT_OWNS_CONTENT);
         if (!new_content)
         {
-            html_set_error("Memory allocation failed for content");
+            if (owned)
+                element->flags |= HTML_ELEMENT_OWNS_CONTENT;
+            html_set_error_code(HTML_ERROR_MEMORY, "Memory allocation failed for content");
             return -1;
         }
 
-        strcpy(new_content, ctx->current->content);
-        strcat(new_content, content);
+        memcpy(new_content, old_content, old_len);
+        memcpy(new_content + old_len, content, add_len + 1);
 
-        free(ctx->current->content);
-        ctx->current->content = new_content;
+        if (owned)
+            free(old_content);
+        element->content = new_content;
     }
     else
     {
-        ctx->current->content = html_strdup(content);
-        if (!ctx->current->content)
+        element->content = html_element_strdup(element, content, HTML_ELEMENT_OWNS_CONTENT);
+        if (!element->content)
         {
-            html_set_error("Memory allocation failed for content");
+            html_set_error_code(HTML_ERROR_MEMORY, "Memory allocation failed for content");
             return -1;
         }
     }
@@ -196,14 +165,14 @@ int html_navigate_to_element(html_context *ctx, const char *id)
 
     if (!ctx || !id)
     {
-        html_set_error("Invalid HTML context or ID");
+        html_set_error_code(HTML_ERROR_INVALID_ARGUMENT, "Invalid HTML context or ID");
         return -1;
     }
 
     html_element *element = html_get_element_by_id(ctx, id);
     if (!element)
     {
-        html_set_error("No element found with ID: %s", id);
+        html_set_error_ex(HTML_ERROR_NOT_FOUND, "No element found with ID: %s", id);
         return -1;
     }
 
@@ -217,14 +186,14 @@ int html_navigate_to_body(html_context *ctx)
 
     if (!ctx)
     {
-        html_set_error("Invalid HTML context");
+        html_set_error_code(HTML_ERROR_INVALID_ARGUMENT, "Invalid HTML context");
         return -1;
     }
 
     html_element *body = html_find_body(ctx);
     if (!body)
     {
-        html_set_error("Body element not found");
+        html_set_error_code(HTML_ERROR_NOT_FOUND, "Body element not found");
         return -1;
     }
 
@@ -238,14 +207,14 @@ int html_navigate_to_head(html_context *ctx)
 
     if (!ctx)
     {
-        html_set_error("Invalid HTML context");
+        html_set_error_code(HTML_ERROR_INVALID_ARGUMENT, "Invalid HTML context");
         return -1;
     }
 
     html_element *head = html_find_head(ctx);
     if (!head)
     {
-        html_set_error("Head element not found");
+        html_set_error_code(HTML_ERROR_NOT_FOUND, "Head element not found");
         return -1;
     }
 
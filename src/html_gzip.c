@@ -0,0 +1,171 @@
+#include "HTML.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef HTML_HAVE_ZLIB
+#include <zlib.h>
+
+// gzip framing on top of deflate's 32K window
+#define HTML_GZIP_WINDOW_BITS (15 + 16)
+// the largest hash table: markup repeats the same few tag prefixes constantly,
+// so fewer chain collisions pay off more than the extra 128K of state costs
+#define HTML_GZIP_MEM_LEVEL 9
+
+static int html_gzip_start(html_gzip_sink *sink)
+{
+    z_stream *stream = (z_stream *)sink->stream;
+    if (deflateInit2(stream, sink->level, Z_DEFLATED, HTML_GZIP_WINDOW_BITS,
+                     HTML_GZIP_MEM_LEVEL, Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+        html_set_error_code(HTML_ERROR_FAILED, "failed to initialize gzip compression");
+        sink->error = 1;
+        return 0;
+    }
+
+    sink->started = 1;
+    return 1;
+}
+
+static int html_gzip_deflate(html_gzip_sink *sink, int mode)
+{
+    z_stream *stream = (z_stream *)sink->stream;
+    int status;
+
+    do
+    {
+        stream->next_out = (Bytef *)sink->buffer;
+        stream->avail_out = (uInt)sink->capacity;
+
+        status = deflate(stream, mode);
+        if (status == Z_STREAM_ERROR)
+        {
+            html_set_error_code(HTML_ERROR_FAILED, "gzip compression failed");
+            sink->error = 1;
+            return 0;
+        }
+
+        size_t produced = sink->capacity - stream->avail_out;
+        if (produced > 0 && !sink->flush(sink->target, sink->buffer, produced))
+        {
+            html_set_error_code(HTML_ERROR_IO, "failed to write compressed output");
+            sink->error = 1;
+            return 0;
+        }
+    } while (stream->avail_out == 0 || (mode == Z_FINISH && status != Z_STREAM_END));
+
+    return 1;
+}
+#endif
+
+int html_gzip_init(html_gzip_sink *sink, int level, html_writer_flush_fn flush, void *target)
+{
+    memset(sink, 0, sizeof(*sink));
+
+#ifdef HTML_HAVE_ZLIB
+    if (!flush || level < 0 || level > HTML_GZIP_BEST)
+    {
+        html_set_error_code(HTML_ERROR_INVALID_ARGUMENT, "Invalid gzip sink parameters");
+        sink->error = 1;
+        return 0;
+    }
+
+    sink->stream = calloc(1, sizeof(z_stream));
+    sink->buffer = (char *)malloc(HTML_WRITER_BLOCK_SIZE);
+    if (!sink->stream || !sink->buffer)
+    {
+        html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for gzip sink");
+        html_gzip_free(sink);
+        sink->error = 1;
+        return 0;
+    }
+
+    sink->capacity = HTML_WRITER_BLOCK_SIZE;
+    sink->flush = flush;
+    sink->target = target;
+    sink->level = level;
+    return 1;
+#else
+    (void)level;
+    (void)flush;
+    (void)target;
+    html_set_error_code(HTML_ERROR_UNSUPPORTED, "gzip output requires building with HTML_HAVE_ZLIB");
+    sink->error = 1;
+    return 0;
+#endif
+}
+
+int html_gzip_set_level(html_gzip_sink *sink, int level)
+{
+    if (sink->started || level < 0 || level > HTML_GZIP_BEST)
+    {
+        html_set_error_code(HTML_ERROR_INVALID_STATE, "gzip level can only be set to 0-9 before any output");
+        return 0;
+    }
+
+    sink->level = level;
+    return 1;
+}
+
+int html_gzip_write(void *target, const char *data, size_t len)
+{
+    html_gzip_sink *sink = (html_gzip_sink *)target;
+    if (sink->error)
+        return 0;
+
+#ifdef HTML_HAVE_ZLIB
+    if (!sink->started && !html_gzip_start(sink))
+        return 0;
+
+    z_stream *stream = (z_stream *)sink->stream;
+    while (len > 0)
+    {
+        // avail_in is 32 bits wide
+        uInt chunk = len > 0x40000000 ? 0x40000000 : (uInt)len;
+        stream->next_in = (Bytef *)data;
+        stream->avail_in = chunk;
+
+        if (!html_gzip_deflate(sink, Z_NO_FLUSH))
+            return 0;
+
+        data += chunk;
+        len -= chunk;
+    }
+    return 1;
+#else
+    (void)data;
+    (void)len;
+    return 0;
+#endif
+}
+
+int html_gzip_finish(html_gzip_sink *sink)
+{
+    if (sink->error)
+        return 0;
+
+#ifdef HTML_HAVE_ZLIB
+    if (!sink->started && !html_gzip_start(sink))
+        return 0;
+
+    z_stream *stream = (z_stream *)sink->stream;
+    stream->next_in = NULL;
+    stream->avail_in = 0;
+    return html_gzip_deflate(sink, Z_FINISH);
+#else
+    return 0;
+#endif
+}
+
+void html_gzip_free(html_gzip_sink *sink)
+{
+#ifdef HTML_HAVE_ZLIB
+    if (sink->started)
+        deflateEnd((z_stream *)sink->stream);
+#endif
+    free(sink->stream);
+    free(sink->buffer);
+    sink->stream = NULL;
+    sink->buffer = NULL;
+    sink->started = 0;
+}
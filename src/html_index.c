@@ -0,0 +1,498 @@
+#include "HTML.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdint.h>
+
+// class names a reset context keeps indexed
+#define HTML_CLASS_INDEX_KEEP 256
+
+typedef struct
+{
+    const html_element *element;
+    int slot;
+} html_slot_entry;
+
+// a class list plus a map from element to its position in it, so elements
+// leave the list without a search
+typedef struct
+{
+    html_element_list elements;
+    html_slot_entry *slots;
+    int slot_capacity;
+    char name[];
+} html_class_bucket;
+
+int html_element_list_append(html_element_list *list, html_element *element)
+{
+    if (list->count >= list->capacity)
+    {
+        int new_capacity = list->capacity ? list->capacity * 2 : 8;
+        html_element **items = (html_element **)realloc(list->items, new_capacity * sizeof(html_element *));
+        if (!items)
+        {
+            html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for element list");
+            return 0;
+        }
+        list->items = items;
+        list->capacity = new_capacity;
+    }
+
+    list->items[list->count++] = element;
+    return 1;
+}
+
+// removed elements leave a hole that the next compaction closes, so the
+// list keeps document order without moving anything on removal
+void html_element_list_remove_at(html_element_list *list, int slot)
+{
+    if (slot < 0 || slot >= list->count || !list->items[slot])
+        return;
+
+    list->items[slot] = NULL;
+    list->removed++;
+}
+
+//////////class slot maps///////
+
+static unsigned int html_slot_hash(const html_element *element, int capacity)
+{
+    uint64_t key = (uint64_t)(uintptr_t)element;
+    return (unsigned int)((key * 0x9E3779B97F4A7C15ULL) >> 32) & (unsigned int)(capacity - 1);
+}
+
+static int html_slot_find(const html_class_bucket *bucket, const html_element *element)
+{
+    if (!bucket->slot_capacity)
+        return -1;
+
+    unsigned int mask = (unsigned int)bucket->slot_capacity - 1;
+    for (unsigned int i = html_slot_hash(element, bucket->slot_capacity);; i = (i + 1) & mask)
+    {
+        if (!bucket->slots[i].element)
+            return -1;
+        if (bucket->slots[i].element == element)
+            return (int)i;
+    }
+}
+
+static void html_slot_put(html_slot_entry *slots, int capacity, const html_element *element, int slot)
+{
+    unsigned int mask = (unsigned int)capacity - 1;
+    unsigned int i = html_slot_hash(element, capacity);
+    while (slots[i].element && slots[i].element != element)
+        i = (i + 1) & mask;
+
+    slots[i].element = element;
+    slots[i].slot = slot;
+}
+
+static int html_slot_insert(html_class_bucket *bucket, const html_element *element, int slot)
+{
+    int live = bucket->elements.count - bucket->elements.removed;
+    if ((live + 1) * 2 > bucket->slot_capacity)
+    {
+        int capacity = bucket->slot_capacity ? bucket->slot_capacity * 2 : 16;
+        html_slot_entry *slots = (html_slot_entry *)calloc(capacity, sizeof(html_slot_entry));
+        if (!slots)
+        {
+            html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for class index");
+            return 0;
+        }
+
+        for (int i = 0; i < bucket->slot_capacity; i++)
+        {
+            if (bucket->slots[i].element)
+                html_slot_put(slots, capacity, bucket->slots[i].element, bucket->slots[i].slot);
+        }
+        free(bucket->slots);
+        bucket->slots = slots;
+        bucket->slot_capacity = capacity;
+    }
+
+    html_slot_put(bucket->slots, bucket->slot_capacity, element, slot);
+    return 1;
+}
+
+static void html_slot_erase(html_class_bucket *bucket, int index)
+{
+    // backward shift keeps every probe run unbroken without tombstones
+    unsigned int mask = (unsigned int)bucket->slot_capacity - 1;
+    unsigned int hole = (unsigned int)index;
+    unsigned int i = hole;
+
+    for (;;)
+    {
+        i = (i + 1) & mask;
+        if (!bucket->slots[i].element)
+            break;
+
+        unsigned int home = html_slot_hash(bucket->slots[i].element, bucket->slot_capacity);
+        if (((i - home) & mask) >= ((i - hole) & mask))
+        {
+            bucket->slots[hole] = bucket->slots[i];
+            hole = i;
+        }
+    }
+
+    bucket->slots[hole].element = NULL;
+}
+
+// closes the holes left by removed elements and updates their recorded
+// positions; bucket is NULL for tag lists, whose positions live in the elements
+static void html_list_compact(html_element_list *list, html_class_bucket *bucket)
+{
+    if (!list->removed)
+        return;
+
+    int count = 0;
+    for (int i = 0; i < list->count; i++)
+    {
+        html_element *element = list->items[i];
+        if (!element)
+            continue;
+
+        if (count != i)
+        {
+            list->items[count] = element;
+            if (bucket)
+                bucket->slots[html_slot_find(bucket, element)].slot = count;
+            else
+                element->index_slot = count;
+        }
+        count++;
+    }
+
+    list->count = count;
+    list->removed = 0;
+}
+
+static int html_list_add(html_element_list *list, html_class_bucket *bucket, html_element *element)
+{
+    if (list->count >= list->capacity && list->removed * 2 >= list->count)
+        html_list_compact(list, bucket);
+
+    return html_element_list_append(list, element);
+}
+
+static html_element_list *html_tag_list(html_context *ctx, int tag, int create)
+{
+    if (tag < 0)
+        return NULL;
+
+    if (tag >= ctx->tag_index_capacity)
+    {
+        if (!create)
+            return NULL;
+
+        int new_capacity = ctx->tag_index_capacity ? ctx->tag_index_capacity : HTML_TAG_KNOWN_COUNT;
+        while (new_capacity <= tag)
+            new_capacity *= 2;
+
+        html_element_list *lists = (html_element_list *)realloc(ctx->tag_index, new_capacity * sizeof(html_element_list));
+        if (!lists)
+        {
+            html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for tag index");
+            return NULL;
+        }
+
+        memset(lists + ctx->tag_index_capacity, 0, (new_capacity - ctx->tag_index_capacity) * sizeof(html_element_list));
+        ctx->tag_index = lists;
+        ctx->tag_index_capacity = new_capacity;
+    }
+
+    return &ctx->tag_index[tag];
+}
+
+static html_class_bucket *html_class_list(html_context *ctx, const char *classname, size_t len, int create)
+{
+    char stack_name[64];
+    char *name = len < sizeof(stack_name) ? stack_name : (char *)malloc(len + 1);
+    if (!name)
+    {
+        html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for class index");
+        return NULL;
+    }
+    memcpy(name, classname, len);
+    name[len] = '\0';
+
+    html_class_bucket *bucket = NULL;
+    if (ctx->class_index)
+        bucket = (html_class_bucket *)html_table_get(ctx->class_index, name);
+
+    if (!bucket && create)
+    {
+        if (!ctx->class_index)
+            ctx->class_index = html_table_create(64);
+
+        bucket = (html_class_bucket *)calloc(1, sizeof(html_class_bucket) + len + 1);
+        if (!ctx->class_index || !bucket)
+        {
+            free(bucket);
+            bucket = NULL;
+            html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for class index");
+        }
+        else
+        {
+            memcpy(bucket->name, name, len + 1);
+            if (html_table_insert(ctx->class_index, bucket->name, bucket) < 0)
+            {
+                free(bucket);
+                bucket = NULL;
+            }
+        }
+    }
+
+    if (name != stack_name)
+        free(name);
+    return bucket;
+}
+
+int html_index_class(html_context *ctx, html_element *element, const char *classname, size_t len)
+{
+    if (!ctx || !element || !classname || len == 0)
+        return 0;
+
+    html_class_bucket *bucket = html_class_list(ctx, classname, len, 1);
+    if (!bucket)
+        return 0;
+
+    // an element listing the same class twice is indexed once
+    if (html_slot_find(bucket, element) >= 0)
+        return 1;
+
+    html_element_list *list = &bucket->elements;
+    if (!html_slot_insert(bucket, element, list->count) || !html_list_add(list, bucket, element))
+    {
+        int index = html_slot_find(bucket, element);
+        if (index >= 0)
+            html_slot_erase(bucket, index);
+        return 0;
+    }
+
+    // compaction may have moved the free position the slot was recorded for
+    bucket->slots[html_slot_find(bucket, element)].slot = list->count - 1;
+    return 1;
+}
+
+void html_unindex_class(html_context *ctx, html_element *element, const char *classname, size_t len)
+{
+    if (!ctx || !element || !classname || len == 0)
+        return;
+
+    html_class_bucket *bucket = html_class_list(ctx, classname, len, 0);
+    if (!bucket)
+        return;
+
+    int index = html_slot_find(bucket, element);
+    if (index < 0)
+        return;
+
+    html_element_list_remove_at(&bucket->elements, bucket->slots[index].slot);
+    html_slot_erase(bucket, index);
+}
+
+static void html_for_each_class(html_context *ctx, html_element *element, int add)
+{
+    const char *classes = html_get_element_attribute(element, "class");
+    if (!classes)
+        return;
+
+    const char *cursor = classes;
+    while (*cursor)
+    {
+        while (isspace((unsigned char)*cursor))
+            cursor++;
+
+        const char *start = cursor;
+        while (*cursor && !isspace((unsigned char)*cursor))
+            cursor++;
+
+        if (cursor > start)
+        {
+            if (add)
+                html_index_class(ctx, element, start, cursor - start);
+            else
+                html_unindex_class(ctx, element, start, cursor - start);
+        }
+    }
+}
+
+void html_index_classes(html_context *ctx, html_element *element)
+{
+    if (ctx && element && (element->flags & HTML_ELEMENT_INDEXED))
+        html_for_each_class(ctx, element, 1);
+}
+
+void html_unindex_classes(html_context *ctx, html_element *element)
+{
+    if (ctx && element && (element->flags & HTML_ELEMENT_INDEXED))
+        html_for_each_class(ctx, element, 0);
+}
+
+int html_index_element(html_context *ctx, html_element *element)
+{
+    if (!ctx || !element)
+        return 0;
+
+    html_element_list *list = html_tag_list(ctx, element->tag, 1);
+    if (!list || !html_list_add(list, NULL, element))
+        return 0;
+
+    element->index_slot = list->count - 1;
+    element->flags |= HTML_ELEMENT_INDEXED;
+    html_for_each_class(ctx, element, 1);
+    return 1;
+}
+
+void html_unindex_element(html_context *ctx, html_element *element)
+{
+    if (!ctx || !element || !(element->flags & HTML_ELEMENT_INDEXED))
+        return;
+
+    // nothing to maintain once the indexes have been dropped at finalize
+    if (!ctx->tag_index)
+    {
+        element->flags &= ~HTML_ELEMENT_INDEXED;
+        return;
+    }
+
+    html_for_each_class(ctx, element, 0);
+
+    html_element_list *list = html_tag_list(ctx, element->tag, 0);
+    if (list && element->index_slot < list->count && list->items[element->index_slot] == element)
+        html_element_list_remove_at(list, element->index_slot);
+
+    element->flags &= ~HTML_ELEMENT_INDEXED;
+}
+
+html_element **html_get_elements_by_class(html_context *ctx, const char *classname, int *count)
+{
+    if (count)
+        *count = 0;
+
+    if (!ctx || !classname)
+        return NULL;
+
+    html_class_bucket *bucket = html_class_list(ctx, classname, strlen(classname), 0);
+    if (!bucket)
+        return NULL;
+
+    html_list_compact(&bucket->elements, bucket);
+    if (bucket->elements.count == 0)
+        return NULL;
+
+    if (count)
+        *count = bucket->elements.count;
+    return bucket->elements.items;
+}
+
+html_element **html_get_elements_by_tag_id(html_context *ctx, int tag, int *count)
+{
+    if (count)
+        *count = 0;
+
+    if (!ctx)
+        return NULL;
+
+    html_element_list *list = html_tag_list(ctx, tag, 0);
+    if (!list)
+        return NULL;
+
+    html_list_compact(list, NULL);
+    if (list->count == 0)
+        return NULL;
+
+    if (count)
+        *count = list->count;
+    return list->items;
+}
+
+html_element **html_get_elements_by_tag(html_context *ctx, const char *tagname, int *count)
+{
+    if (count)
+        *count = 0;
+
+    if (!tagname)
+        return NULL;
+
+    int tag = html_tag_lookup(tagname);
+    if (tag == HTML_TAG_UNKNOWN)
+        return NULL;
+
+    return html_get_elements_by_tag_id(ctx, tag, count);
+}
+
+void html_reset_indexes(html_context *ctx)
+{
+    if (!ctx)
+        return;
+
+    // everything keeps its storage; only a class index that has collected
+    // many one-off names is dropped
+    if (ctx->class_index && ctx->class_index->size <= HTML_CLASS_INDEX_KEEP)
+    {
+        for (int i = 0; i < ctx->class_index->capacity; i++)
+        {
+            if (ctx->class_index->keys[i])
+            {
+                html_class_bucket *bucket = (html_class_bucket *)ctx->class_index->values[i];
+                bucket->elements.count = 0;
+                bucket->elements.removed = 0;
+                if (bucket->slots)
+                    memset(bucket->slots, 0, bucket->slot_capacity * sizeof(html_slot_entry));
+            }
+        }
+    }
+    else if (ctx->class_index)
+    {
+        for (int i = 0; i < ctx->class_index->capacity; i++)
+        {
+            if (ctx->class_index->keys[i])
+            {
+                html_class_bucket *bucket = (html_class_bucket *)ctx->class_index->values[i];
+                free(bucket->elements.items);
+                free(bucket->slots);
+                free(bucket);
+            }
+        }
+        html_table_clear(ctx->class_index);
+    }
+
+    for (int i = 0; i < ctx->tag_index_capacity; i++)
+    {
+        ctx->tag_index[i].count = 0;
+        ctx->tag_index[i].removed = 0;
+    }
+}
+
+void html_free_indexes(html_context *ctx)
+{
+    if (!ctx)
+        return;
+
+    if (ctx->class_index)
+    {
+        for (int i = 0; i < ctx->class_index->capacity; i++)
+        {
+            if (ctx->class_index->keys[i])
+            {
+                html_class_bucket *bucket = (html_class_bucket *)ctx->class_index->values[i];
+                free(bucket->elements.items);
+                free(bucket->slots);
+                free(bucket);
+            }
+        }
+        html_table_free(ctx->class_index);
+        ctx->class_index = NULL;
+    }
+
+    for (int i = 0; i < ctx->tag_index_capacity; i++)
+    {
+        free(ctx->tag_index[i].items);
+    }
+    free(ctx->tag_index);
+    ctx->tag_index = NULL;
+    ctx->tag_index_capacity = 0;
+}
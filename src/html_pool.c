@@ -0,0 +1,117 @@
+#include "HTML.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+struct html_context_pool
+{
+    html_context **idle;
+    int count;
+    int capacity;
+    int flags;
+#ifdef _WIN32
+    SRWLOCK lock;
+#else
+    pthread_mutex_t lock;
+#endif
+};
+
+#ifdef _WIN32
+#define html_pool_lock(pool) AcquireSRWLockExclusive(&(pool)->lock)
+#define html_pool_unlock(pool) ReleaseSRWLockExclusive(&(pool)->lock)
+#else
+#define html_pool_lock(pool) pthread_mutex_lock(&(pool)->lock)
+#define html_pool_unlock(pool) pthread_mutex_unlock(&(pool)->lock)
+#endif
+
+html_context_pool *html_context_pool_create(int flags, int max_idle)
+{
+    if (max_idle <= 0)
+        max_idle = HTML_POOL_DEFAULT_SIZE;
+
+    html_context_pool *pool = (html_context_pool *)calloc(1, sizeof(html_context_pool));
+    if (pool)
+        pool->idle = (html_context **)malloc(max_idle * sizeof(html_context *));
+
+    if (!pool || !pool->idle)
+    {
+        free(pool);
+        html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for context pool");
+        return NULL;
+    }
+
+    // pooled documents render to strings, so output related flags do not
+    // apply; the arena is what lets a reset keep the element storage, without
+    // it every node of the old page would be freed and allocated again
+    pool->flags = (flags | HTML_CONTEXT_ARENA) & ~(HTML_CONTEXT_STREAMING | HTML_CONTEXT_GZIP);
+    pool->capacity = max_idle;
+#ifdef _WIN32
+    InitializeSRWLock(&pool->lock);
+#else
+    pthread_mutex_init(&pool->lock, NULL);
+#endif
+    return pool;
+}
+
+html_context *html_context_pool_acquire(html_context_pool *pool, const char *title)
+{
+    if (!pool)
+        return NULL;
+
+    html_context *ctx = NULL;
+    html_pool_lock(pool);
+    if (pool->count > 0)
+        ctx = pool->idle[--pool->count];
+    html_pool_unlock(pool);
+
+    if (!ctx)
+        return html_init_string_ex(title, pool->flags);
+
+    // the old document is dropped here, on the thread that wants the context
+    if (!html_context_reset(ctx, title))
+    {
+        html_finalize(ctx);
+        return NULL;
+    }
+    return ctx;
+}
+
+void html_context_pool_release(html_context_pool *pool, html_context *ctx)
+{
+    if (!ctx)
+        return;
+
+    if (pool)
+    {
+        html_pool_lock(pool);
+        int kept = pool->count < pool->capacity;
+        if (kept)
+            pool->idle[pool->count++] = ctx;
+        html_pool_unlock(pool);
+
+        if (kept)
+            return;
+    }
+
+    html_finalize(ctx);
+}
+
+void html_context_pool_free(html_context_pool *pool)
+{
+    if (!pool)
+        return;
+
+    for (int i = 0; i < pool->count; i++)
+        html_finalize(pool->idle[i]);
+
+#ifndef _WIN32
+    pthread_mutex_destroy(&pool->lock);
+#endif
+    free(pool->idle);
+    free(pool);
+}
@@ -0,0 +1,1796 @@
+#include "HTML.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+typedef struct
+{
+    const html_element *element;
+    int next;
+} html_render_frame;
+
+typedef struct
+{
+    html_render_frame *frames;
+    int depth;
+    int capacity;
+    html_render_frame local[32];
+} html_render_stack;
+
+// render options resolved once per render
+typedef struct
+{
+    int minified;
+    int escape;
+    int indent_width;
+    int indent_limit;
+    const char *newline;
+    size_t newline_len;
+} html_render_format;
+
+void html_render_options_init(html_render_options *options)
+{
+    if (!options)
+        return;
+
+    options->flags = 0;
+    options->indent_width = HTML_RENDER_DEFAULT_INDENT_WIDTH;
+    options->indent_limit = HTML_RENDER_DEFAULT_INDENT_LIMIT;
+}
+
+static void html_resolve_format(html_render_format *format, const html_render_options *options)
+{
+    html_render_options defaults;
+    if (!options)
+    {
+        html_render_options_init(&defaults);
+        options = &defaults;
+    }
+
+    format->minified = (options->flags & HTML_RENDER_MINIFIED) != 0;
+    format->escape = (options->flags & HTML_RENDER_ESCAPE) != 0;
+    format->indent_width = options->indent_width > 0 ? options->indent_width : 0;
+    format->indent_limit = options->indent_limit > 0 ? options->indent_limit : INT_MAX;
+
+    if (options->flags & HTML_RENDER_CRLF)
+    {
+        format->newline = "\r\n";
+        format->newline_len = 2;
+    }
+    else
+    {
+        format->newline = "\n";
+        format->newline_len = 1;
+    }
+}
+
+static int html_indent_width(const html_render_format *format, int level)
+{
+    if (level <= 0 || format->indent_width == 0)
+        return 0;
+
+    if (level > format->indent_limit / format->indent_width)
+        return format->indent_limit;
+
+    return level * format->indent_width;
+}
+
+static int html_escapes_values(const html_element *element, const html_render_format *format)
+{
+    return format->escape || (element->flags & HTML_ELEMENT_ESCAPE);
+}
+
+// script and style text is never entity-decoded by browsers, so it stays raw
+static int html_escapes_content(const html_element *element, const html_render_format *format)
+{
+    return html_escapes_values(element, format) && element->tag != HTML_TAG_SCRIPT &&
+           element->tag != HTML_TAG_STYLE;
+}
+
+static void html_write_content(html_writer *writer, const html_element *element, const html_render_format *format)
+{
+    if (html_escapes_content(element, format))
+        html_writer_append_escaped(writer, element->content, strlen(element->content));
+    else
+        html_writer_append_ref(writer, element->content, strlen(element->content));
+}
+
+static void html_write_open_tag(html_writer *writer, const html_element *element, const html_render_format *format)
+{
+    int escape = html_escapes_values(element, format);
+
+    html_writer_putc(writer, '<');
+    html_writer_puts(writer, element->tagname);
+
+    for (int i = 0; i < element->attribute_count; i++)
+    {
+        const html_attribute *attr = &element->attributes[i];
+        html_writer_putc(writer, ' ');
+        html_writer_puts(writer, attr->name);
+
+        if (!attr->value)
+            continue;
+
+        html_writer_putc(writer, '=');
+        if (attr->quote)
+            html_writer_putc(writer, attr->quote);
+        if (escape)
+            html_writer_append_escaped(writer, attr->value, attr->length);
+        else
+            html_writer_append_ref(writer, attr->value, attr->length);
+        if (attr->quote)
+            html_writer_putc(writer, attr->quote);
+    }
+}
+
+// writes everything up to the children; returns 1 when the children and the
+// closing tag still have to follow
+static int html_write_start(html_writer *writer, const html_element *element, int indent,
+                            const html_render_format *format)
+{
+    html_writer_indent(writer, indent);
+    html_write_open_tag(writer, element, format);
+
+    if (html_tag_is_self_closing(element->tag))
+    {
+        html_writer_append(writer, " />", 3);
+        html_writer_append(writer, format->newline, format->newline_len);
+        return 0;
+    }
+
+    html_writer_putc(writer, '>');
+
+    if (element->content && element->content[0])
+    {
+        int is_block = html_tag_is_block(element->tag);
+
+        if (is_block)
+        {
+            html_writer_append(writer, format->newline, format->newline_len);
+            html_writer_indent(writer, indent + format->indent_width);
+        }
+
+        html_write_content(writer, element, format);
+
+        if (is_block)
+        {
+            html_writer_append(writer, format->newline, format->newline_len);
+            html_writer_indent(writer, indent);
+        }
+    }
+    else if (element->children_count > 0)
+    {
+        html_writer_append(writer, format->newline, format->newline_len);
+        return 1;
+    }
+
+    html_writer_append(writer, "</", 2);
+    html_writer_puts(writer, element->tagname);
+    html_writer_putc(writer, '>');
+    html_writer_append(writer, format->newline, format->newline_len);
+    return 0;
+}
+
+static void html_write_end(html_writer *writer, const html_element *element, int indent,
+                           const html_render_format *format)
+{
+    html_writer_indent(writer, indent);
+    html_writer_append(writer, "</", 2);
+    html_writer_puts(writer, element->tagname);
+    html_writer_putc(writer, '>');
+    html_writer_append(writer, format->newline, format->newline_len);
+}
+
+// minified output carries no indentation or line breaks at all
+static int html_write_start_minified(html_writer *writer, const html_element *element,
+                                     const html_render_format *format)
+{
+    html_write_open_tag(writer, element, format);
+    html_writer_putc(writer, '>');
+
+    if (html_tag_is_self_closing(element->tag))
+        return 0;
+
+    if (element->content && element->content[0])
+        html_write_content(writer, element, format);
+    else if (element->children_count > 0)
+        return 1;
+
+    html_writer_append(writer, "</", 2);
+    html_writer_puts(writer, element->tagname);
+    html_writer_putc(writer, '>');
+    return 0;
+}
+
+static void html_write_end_minified(html_writer *writer, const html_element *element)
+{
+    html_writer_append(writer, "</", 2);
+    html_writer_puts(writer, element->tagname);
+    html_writer_putc(writer, '>');
+}
+
+static size_t html_measure_content(const html_element *element, const html_render_format *format)
+{
+    size_t len = strlen(element->content);
+    return html_escapes_content(element, format) ? html_escaped_length(element->content, len) : len;
+}
+
+static size_t html_measure_open_tag(const html_element *element, const html_render_format *format)
+{
+    int escape = html_escapes_values(element, format);
+    size_t size = 1 + strlen(element->tagname);
+
+    for (int i = 0; i < element->attribute_count; i++)
+    {
+        const html_attribute *attr = &element->attributes[i];
+        size += 1 + strlen(attr->name);
+        if (attr->value)
+            size += 1 + (escape ? html_escaped_length(attr->value, attr->length) : attr->length) +
+                    (attr->quote ? 2 : 0);
+    }
+
+    return size;
+}
+
+static size_t html_measure_start(const html_element *element, int indent, const html_render_format *format, int *open)
+{
+    size_t close_len = 3 + strlen(element->tagname);
+    size_t size = html_measure_open_tag(element, format) + 1;
+    *open = 0;
+
+    if (format->minified)
+    {
+        if (html_tag_is_self_closing(element->tag))
+            return size;
+
+        if (element->content && element->content[0])
+            size += html_measure_content(element, format);
+        else if (element->children_count > 0)
+        {
+            *open = 1;
+            return size;
+        }
+
+        return size + close_len;
+    }
+
+    size += (size_t)indent;
+
+    if (html_tag_is_self_closing(element->tag))
+        return size + 2 + format->newline_len;
+
+    if (element->content && element->content[0])
+    {
+        size += html_measure_content(element, format);
+        if (html_tag_is_block(element->tag))
+            size += 2 * format->newline_len + (size_t)(indent + format->indent_width) + (size_t)indent;
+    }
+    else if (element->children_count > 0)
+    {
+        *open = 1;
+        return size + format->newline_len;
+    }
+
+    return size + close_len + format->newline_len;
+}
+
+static size_t html_measure_end(const html_element *element, int indent, const html_render_format *format)
+{
+    size_t size = 3 + strlen(element->tagname);
+    if (!format->minified)
+        size += (size_t)indent + format->newline_len;
+    return size;
+}
+
+static int html_render_push(html_render_stack *stack, const html_element *element)
+{
+    if (stack->depth >= stack->capacity)
+    {
+        int new_capacity = stack->capacity * 2;
+        html_render_frame *frames;
+
+        if (stack->frames == stack->local)
+        {
+            frames = (html_render_frame *)malloc(new_capacity * sizeof(html_render_frame));
+            if (frames)
+                memcpy(frames, stack->local, sizeof(stack->local));
+        }
+        else
+        {
+            frames = (html_render_frame *)realloc(stack->frames, new_capacity * sizeof(html_render_frame));
+        }
+
+        if (!frames)
+        {
+            html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for render stack");
+            return 0;
+        }
+
+        stack->frames = frames;
+        stack->capacity = new_capacity;
+    }
+
+    stack->frames[stack->depth].element = element;
+    stack->frames[stack->depth].next = 0;
+    stack->depth++;
+    return 1;
+}
+
+static void html_render_stack_init(html_render_stack *stack)
+{
+    stack->frames = stack->local;
+    stack->depth = 0;
+    stack->capacity = (int)(sizeof(stack->local) / sizeof(stack->local[0]));
+}
+
+static void html_render_stack_free(html_render_stack *stack)
+{
+    if (stack->frames != stack->local)
+        free(stack->frames);
+    stack->frames = stack->local;
+}
+
+static int html_write_first(html_writer *writer, html_render_stack *stack, const html_element *element, int level,
+                            const html_render_format *format)
+{
+    int open = format->minified ? html_write_start_minified(writer, element, format)
+                                : html_write_start(writer, element, html_indent_width(format, level), format);
+
+    return open ? html_render_push(stack, element) : 1;
+}
+
+// advances the walk by one start or end tag
+static int html_write_step(html_writer *writer, html_render_stack *stack, int level,
+                           const html_render_format *format)
+{
+    html_render_frame *frame = &stack->frames[stack->depth - 1];
+
+    if (frame->next < frame->element->children_count)
+    {
+        const html_element *child = frame->element->children[frame->next++];
+        return html_write_first(writer, stack, child, level + stack->depth, format);
+    }
+
+    stack->depth--;
+    if (format->minified)
+        html_write_end_minified(writer, frame->element);
+    else
+        html_write_end(writer, frame->element, html_indent_width(format, level + stack->depth), format);
+    return 1;
+}
+
+static int html_write_tree(html_writer *writer, const html_element *element, int level,
+                           const html_render_format *format)
+{
+    html_render_stack stack;
+    html_render_stack_init(&stack);
+
+    int result = html_write_first(writer, &stack, element, level, format);
+    while (result && stack.depth > 0)
+    {
+        result = html_write_step(writer, &stack, level, format);
+    }
+
+    html_render_stack_free(&stack);
+    return result && !writer->error;
+}
+
+int html_write_element(html_writer *writer, const html_element *element, int level)
+{
+    return html_write_element_ex(writer, element, level, NULL);
+}
+
+int html_write_element_ex(html_writer *writer, const html_element *element, int level,
+                          const html_render_options *options)
+{
+    if (!writer || !element)
+        return 0;
+
+    html_render_format format;
+    html_resolve_format(&format, options);
+    return html_write_tree(writer, element, level, &format);
+}
+
+static size_t html_measure_element(const html_element *element, int level, const html_render_format *format)
+{
+    int open;
+    size_t size = html_measure_start(element, html_indent_width(format, level), format, &open);
+    if (!open)
+        return size;
+
+    html_render_stack stack;
+    html_render_stack_init(&stack);
+    int result = html_render_push(&stack, element);
+
+    while (result && stack.depth > 0)
+    {
+        html_render_frame *frame = &stack.frames[stack.depth - 1];
+
+        if (frame->next < frame->element->children_count)
+        {
+            const html_element *child = frame->element->children[frame->next++];
+            size += html_measure_start(child, html_indent_width(format, level + stack.depth), format, &open);
+            if (open)
+                result = html_render_push(&stack, child);
+        }
+        else
+        {
+            stack.depth--;
+            size += html_measure_end(frame->element, html_indent_width(format, level + stack.depth), format);
+        }
+    }
+
+    html_render_stack_free(&stack);
+    return size;
+}
+
+static void html_write_doctype(html_writer *writer, const html_render_format *format)
+{
+    html_writer_append(writer, "<!DOCTYPE html>", 15);
+    if (!format->minified)
+        html_writer_append(writer, format->newline, format->newline_len);
+}
+
+size_t html_render_length(html_context *ctx)
+{
+    return html_render_length_ex(ctx, NULL);
+}
+
+size_t html_render_length_ex(html_context *ctx, const html_render_options *options)
+{
+    if (!ctx || !ctx->root)
+        return 0;
+
+    html_render_format format;
+    html_resolve_format(&format, options);
+
+    return 15 + (format.minified ? 0 : format.newline_len) + html_measure_element(ctx->root, 0, &format);
+}
+
+//////////render cache///////
+
+typedef struct
+{
+    html_element *element;
+    int next;
+    int has_old;
+    size_t old_start;
+    size_t new_start;
+    size_t parent_start;
+} html_cache_frame;
+
+static int html_cache_matches(const html_render_cache *cache, const html_render_options *options, int level)
+{
+    html_render_options defaults;
+    if (!options)
+    {
+        html_render_options_init(&defaults);
+        options = &defaults;
+    }
+
+    return cache->data && cache->level == level && cache->options.flags == options->flags &&
+           cache->options.indent_width == options->indent_width &&
+           cache->options.indent_limit == options->indent_limit;
+}
+
+static void html_cache_store(html_element *element, size_t start, size_t end, size_t parent_start)
+{
+    element->cache_offset = start - parent_start;
+    element->cache_length = end - start;
+    element->flags = (element->flags | HTML_ELEMENT_CACHED) & ~HTML_ELEMENT_DIRTY;
+}
+
+// renders the document into a new buffer, copying every clean subtree from the
+// previous output; cached offsets are relative to the parent so they survive
+// everything around them moving
+static int html_render_cached(html_context *ctx, const html_render_options *options, int level)
+{
+    html_render_cache *cache = ctx->render_cache;
+    if (!cache)
+    {
+        cache = (html_render_cache *)calloc(1, sizeof(html_render_cache));
+        if (!cache)
+        {
+            html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for render cache");
+            return 0;
+        }
+        ctx->render_cache = cache;
+    }
+
+    html_render_format format;
+    html_resolve_format(&format, options);
+
+    const char *old = cache->data;
+    int valid = html_cache_matches(cache, options, level);
+
+    html_writer out;
+    if (!html_writer_init(&out, cache->length + 4096, NULL, NULL))
+        return 0;
+
+    int capacity = 64;
+    int depth = 0;
+    html_cache_frame *frames = (html_cache_frame *)malloc(capacity * sizeof(html_cache_frame));
+    if (!frames)
+    {
+        html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for render cache");
+        html_writer_free(&out);
+        return 0;
+    }
+
+    html_write_doctype(&out, &format);
+
+    // the root hangs off a virtual parent at offset 0 of both buffers
+    html_cache_frame top = {NULL, 0, valid, 0, 0, 0};
+    html_element *pending = ctx->root;
+    int result = 1;
+
+    while (result)
+    {
+        html_cache_frame *parent = depth > 0 ? &frames[depth - 1] : &top;
+
+        if (!pending)
+        {
+            if (depth == 0)
+                break;
+
+            if (parent->next < parent->element->children_count)
+            {
+                pending = parent->element->children[parent->next++];
+                continue;
+            }
+
+            // all children are out, close the element and record its span
+            depth--;
+            int element_level = level + depth;
+            if (format.minified)
+                html_write_end_minified(&out, parent->element);
+            else
+                html_write_end(&out, parent->element, html_indent_width(&format, element_level), &format);
+
+            html_cache_store(parent->element, parent->new_start, out.length, parent->parent_start);
+            continue;
+        }
+
+        html_element *element = pending;
+        pending = NULL;
+
+        size_t start = out.length;
+        int element_level = level + depth;
+        int cached = parent->has_old && (element->flags & HTML_ELEMENT_CACHED);
+
+        if (cached && !(element->flags & HTML_ELEMENT_DIRTY))
+        {
+            html_writer_append(&out, old + parent->old_start + element->cache_offset, element->cache_length);
+            element->cache_offset = start - parent->new_start;
+            continue;
+        }
+
+        int open = format.minified ? html_write_start_minified(&out, element, &format)
+                                   : html_write_start(&out, element, html_indent_width(&format, element_level), &format);
+        if (!open)
+        {
+            // children hidden behind content lose their spans with the output they came from
+            for (int i = 0; i < element->children_count; i++)
+                element->children[i]->flags &= ~HTML_ELEMENT_CACHED;
+
+            html_cache_store(element, start, out.length, parent->new_start);
+            continue;
+        }
+
+        if (depth >= capacity)
+        {
+            html_cache_frame *grown = (html_cache_frame *)realloc(frames, capacity * 2 * sizeof(html_cache_frame));
+            if (!grown)
+            {
+                html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for render cache");
+                result = 0;
+                break;
+            }
+            frames = grown;
+            capacity *= 2;
+            parent = depth > 0 ? &frames[depth - 1] : &top;
+        }
+
+        html_cache_frame *frame = &frames[depth++];
+        frame->element = element;
+        frame->next = 0;
+        frame->has_old = cached;
+        frame->old_start = cached ? parent->old_start + element->cache_offset : 0;
+        frame->new_start = start;
+        frame->parent_start = parent->new_start;
+    }
+
+    free(frames);
+
+    if (!result || out.error)
+    {
+        // spans may already point into the discarded buffer
+        ctx->root->flags &= ~HTML_ELEMENT_CACHED;
+        free(cache->data);
+        cache->data = NULL;
+        cache->length = 0;
+        html_writer_free(&out);
+        return 0;
+    }
+
+    free(cache->data);
+    cache->data = out.data;
+    cache->length = out.length;
+    cache->level = level;
+    if (options)
+        cache->options = *options;
+    else
+        html_render_options_init(&cache->options);
+    return 1;
+}
+
+void html_render_cache_free(html_context *ctx)
+{
+    if (!ctx || !ctx->render_cache)
+        return;
+
+    free(ctx->render_cache->data);
+    free(ctx->render_cache);
+    ctx->render_cache = NULL;
+}
+
+static int html_flush_output(void *target, const char *data, size_t len)
+{
+    html_context *ctx = (html_context *)target;
+    if (!html_sink_write(ctx->sink, data, len))
+        return 0;
+
+    // the precompressed copy sees exactly the bytes of the plain file
+    return !ctx->gzip || html_gzip_write(ctx->gzip, data, len);
+}
+
+static int html_writer_init_output(html_writer *writer, html_context *ctx)
+{
+    if (!ctx->gzip)
+        return html_writer_init(writer, HTML_WRITER_BLOCK_SIZE, html_sink_write, ctx->sink);
+
+    return html_writer_init(writer, HTML_WRITER_BLOCK_SIZE, html_flush_output, ctx);
+}
+
+// writes the whole document at the given base indentation, then flushes and
+// releases the writer
+static int html_render_document(html_context *ctx, html_writer *writer, const html_render_options *options, int level)
+{
+    html_render_format format;
+    html_resolve_format(&format, options);
+
+    ctx->indent_level = level;
+
+    int result = 1;
+    if (ctx->flags & HTML_CONTEXT_RENDER_CACHE)
+    {
+        result = html_render_cached(ctx, options, ctx->indent_level) &&
+                 html_writer_append(writer, ctx->render_cache->data, ctx->render_cache->length);
+    }
+    else
+    {
+        html_write_doctype(writer, &format);
+        html_write_tree(writer, ctx->root, ctx->indent_level, &format);
+    }
+
+    result = html_writer_flush(writer) && result;
+    html_writer_free(writer);
+    return result;
+}
+
+//////////streaming///////
+
+static html_writer *html_stream_writer(html_context *ctx)
+{
+    if (ctx->stream_writer)
+        return ctx->stream_writer;
+
+    html_writer *writer = (html_writer *)malloc(sizeof(html_writer));
+    if (!writer)
+    {
+        html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for stream writer");
+        return NULL;
+    }
+
+    if (!html_writer_init_output(writer, ctx))
+    {
+        free(writer);
+        return NULL;
+    }
+
+    ctx->stream_writer = writer;
+    return writer;
+}
+
+static int html_element_depth(const html_element *element)
+{
+    int depth = 0;
+    for (const html_element *node = element->parent; node; node = node->parent)
+        depth++;
+    return depth;
+}
+
+// writes the part of a child that has not been streamed yet; a child whose
+// start tag already went out only has its remaining children and end tag left
+static int html_stream_write_child(html_writer *writer, const html_element *child, int level,
+                                   const html_render_format *format)
+{
+    if (!(child->flags & HTML_ELEMENT_STREAM_OPEN))
+        return html_write_tree(writer, child, level, format);
+
+    for (int i = 0; i < child->children_count; i++)
+    {
+        if (!html_write_tree(writer, child->children[i], level + 1, format))
+            return 0;
+    }
+
+    html_write_end(writer, child, html_indent_width(format, level), format);
+    return !writer->error;
+}
+
+// serializes and frees the children of parent up to and including index last
+static int html_stream_children(html_writer *writer, html_element *parent, int last, int level,
+                                const html_render_format *format)
+{
+    for (int i = 0; i <= last; i++)
+    {
+        if (!html_stream_write_child(writer, parent->children[i], level, format))
+            return 0;
+    }
+
+    html_element **children = parent->children;
+    int count = last + 1;
+
+    // detach the whole run at once so each free skips the sibling search
+    for (int i = 0; i < count; i++)
+    {
+        html_element *child = children[i];
+        children[i] = NULL;
+        child->parent = NULL;
+        html_free_element(child);
+    }
+
+    memmove(&children[0], &children[count], (parent->children_count - count) * sizeof(html_element *));
+    parent->children_count -= count;
+    return 1;
+}
+
+static int html_stream_open(html_context *ctx, html_writer *writer, html_element *element,
+                            const html_render_format *format)
+{
+    int level = html_element_depth(element) + 1;
+
+    if (element == ctx->root)
+        html_write_doctype(writer, format);
+    else if (element->parent->children[0] != element)
+    {
+        int index = 0;
+        while (element->parent->children[index] != element)
+            index++;
+
+        if (!html_stream_children(writer, element->parent, index - 1, level, format))
+            return 0;
+    }
+
+    html_write_start(writer, element, html_indent_width(format, level), format);
+    element->flags |= HTML_ELEMENT_STREAM_OPEN;
+    return !writer->error;
+}
+
+int html_stream_element(html_context *ctx, html_element *element)
+{
+    if (!ctx || !element || !(ctx->flags & HTML_CONTEXT_STREAMING) || !ctx->sink)
+        return 1;
+
+    html_element *parent = element->parent;
+    if (!parent)
+        return 1;
+
+    // content or a void tag on an ancestor hides its children, and detached
+    // subtrees are not part of the output at all; those stay in memory
+    const html_element *top = parent;
+    for (const html_element *node = parent; node; node = node->parent)
+    {
+        if ((node->content && node->content[0]) || html_tag_is_self_closing(node->tag))
+            return 1;
+        top = node;
+    }
+    if (top != ctx->root)
+        return 1;
+
+    html_writer *writer = html_stream_writer(ctx);
+    if (!writer)
+        return 0;
+
+    html_render_format format;
+    html_resolve_format(&format, NULL);
+
+    // start tags go out top-down, each one flushing the siblings before it
+    while (!(parent->flags & HTML_ELEMENT_STREAM_OPEN))
+    {
+        html_element *next = parent;
+        while (next->parent && !(next->parent->flags & HTML_ELEMENT_STREAM_OPEN))
+            next = next->parent;
+
+        if (!html_stream_open(ctx, writer, next, &format))
+            return 0;
+    }
+
+    int index = parent->children_count - 1;
+    while (index >= 0 && parent->children[index] != element)
+        index--;
+    if (index < 0)
+        return 1;
+
+    return html_stream_children(writer, parent, index, html_element_depth(element) + 1, &format);
+}
+
+static int html_stream_finish(html_context *ctx)
+{
+    html_writer *writer = ctx->stream_writer;
+
+    html_render_format format;
+    html_resolve_format(&format, NULL);
+
+    // open elements form a chain through the first child of each open parent
+    html_element *node = ctx->root;
+    int level = 1;
+    while (node->children_count > 0 && (node->children[0]->flags & HTML_ELEMENT_STREAM_OPEN))
+    {
+        node = node->children[0];
+        level++;
+    }
+
+    int start = 0;
+    for (;;)
+    {
+        for (int i = start; i < node->children_count; i++)
+        {
+            html_write_tree(writer, node->children[i], level + 1, &format);
+        }
+        html_write_end(writer, node, html_indent_width(&format, level), &format);
+
+        if (node == ctx->root)
+            break;
+
+        node = node->parent;
+        level--;
+        start = 1;
+    }
+
+    int result = html_writer_flush(writer);
+    html_stream_free(ctx);
+    return result;
+}
+
+void html_stream_free(html_context *ctx)
+{
+    if (!ctx || !ctx->stream_writer)
+        return;
+
+    html_writer_free(ctx->stream_writer);
+    free(ctx->stream_writer);
+    ctx->stream_writer = NULL;
+}
+
+int html_render(html_context *ctx)
+{
+    return html_render_ex(ctx, NULL);
+}
+
+int html_render_ex(html_context *ctx, const html_render_options *options)
+{
+    if (!ctx || !ctx->root || !ctx->sink)
+        return 0;
+
+    ctx->rendered = 1;
+
+    int result;
+    if (ctx->root->flags & HTML_ELEMENT_STREAM_OPEN)
+    {
+        // once the stream is finished the closed subtrees are gone, so there
+        // is nothing left that could be written again
+        if (!ctx->stream_writer)
+        {
+            html_set_error_code(HTML_ERROR_INVALID_STATE, "Document has already been streamed to its output");
+            return 0;
+        }
+        result = html_stream_finish(ctx);
+    }
+    else
+    {
+        html_writer writer;
+        result = html_writer_init_output(&writer, ctx) && html_render_document(ctx, &writer, options, 1);
+    }
+
+    return html_sink_flush(ctx->sink) && result;
+}
+
+int html_render_fd(html_context *ctx, int fd)
+{
+    return html_render_fd_ex(ctx, fd, NULL);
+}
+
+int html_render_fd_ex(html_context *ctx, int fd, const html_render_options *options)
+{
+    if (!ctx || !ctx->root || fd < 0)
+        return 0;
+
+    if (ctx->root->flags & HTML_ELEMENT_STREAM_OPEN)
+    {
+        html_set_error_code(HTML_ERROR_INVALID_STATE, "Document is already being streamed to its output file");
+        return 0;
+    }
+
+    html_writer writer;
+    if (!html_writer_init_fd(&writer, fd))
+        return 0;
+
+    return html_render_document(ctx, &writer, options, 1);
+}
+
+static int html_flush_stream(void *target, const char *data, size_t len)
+{
+    return fwrite(data, 1, len, (FILE *)target) == len;
+}
+
+static int html_flush_memory(void *target, const char *data, size_t len)
+{
+    return html_writer_append((html_writer *)target, data, len);
+}
+
+int html_render_gzip(html_context *ctx, FILE *file, int level)
+{
+    if (!ctx || !ctx->root || !file)
+        return 0;
+
+    if (ctx->root->flags & HTML_ELEMENT_STREAM_OPEN)
+    {
+        html_set_error_code(HTML_ERROR_INVALID_STATE, "Document is already being streamed to its output file");
+        return 0;
+    }
+
+    html_gzip_sink sink;
+    if (!html_gzip_init(&sink, level, html_flush_stream, file))
+        return 0;
+
+    // the render buffer feeds deflate a block at a time, so the page is
+    // compressed while the tree is walked and never held uncompressed
+    html_writer writer;
+    int result = html_writer_init(&writer, HTML_WRITER_BLOCK_SIZE, html_gzip_write, &sink) &&
+                 html_render_document(ctx, &writer, NULL, 1) &&
+                 html_gzip_finish(&sink);
+
+    html_gzip_free(&sink);
+    return result;
+}
+
+char *html_render_to_gzip(html_context *ctx, int level, size_t *length)
+{
+    html_clear_error();
+
+    if (!ctx || !ctx->root || !length)
+    {
+        html_set_error_code(HTML_ERROR_INVALID_ARGUMENT, "Invalid HTML context or root element");
+        return NULL;
+    }
+
+    *length = 0;
+
+    html_writer output;
+    if (!html_writer_init(&output, 4096, NULL, NULL))
+        return NULL;
+
+    html_gzip_sink sink;
+    if (!html_gzip_init(&sink, level, html_flush_memory, &output))
+    {
+        html_writer_free(&output);
+        return NULL;
+    }
+
+    // same bytes as html_render_to_string, compressed on the way out
+    html_writer writer;
+    int result = html_writer_init(&writer, HTML_WRITER_BLOCK_SIZE, html_gzip_write, &sink) &&
+                 html_render_document(ctx, &writer, NULL, 0) &&
+                 html_gzip_finish(&sink) && !output.error;
+
+    html_gzip_free(&sink);
+    if (!result)
+    {
+        html_writer_free(&output);
+        return NULL;
+    }
+
+    *length = output.length;
+    return output.data;
+}
+
+int html_render_element(html_context *ctx, html_element *element)
+{
+    if (!ctx || !element || !ctx->sink)
+        return 0;
+
+    html_writer writer;
+    if (!html_writer_init_output(&writer, ctx))
+        return 0;
+
+    html_write_element(&writer, element, ctx->indent_level);
+
+    int result = html_writer_flush(&writer);
+    html_writer_free(&writer);
+    return result;
+}
+
+char *html_render_to_string(html_context *ctx)
+{
+    return html_render_to_string_ex(ctx, NULL);
+}
+
+char *html_render_to_string_ex(html_context *ctx, const html_render_options *options)
+{
+    html_clear_error();
+
+    if (!ctx || !ctx->root)
+    {
+        html_set_error_code(HTML_ERROR_INVALID_ARGUMENT, "Invalid HTML context or root element");
+        return NULL;
+    }
+
+    if (ctx->flags & HTML_CONTEXT_RENDER_CACHE)
+    {
+        ctx->indent_level = 0;
+        if (!html_render_cached(ctx, options, ctx->indent_level))
+            return NULL;
+
+        char *html_string = (char *)malloc(ctx->render_cache->length + 1);
+        if (!html_string)
+        {
+            html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for HTML string");
+            return NULL;
+        }
+
+        memcpy(html_string, ctx->render_cache->data, ctx->render_cache->length);
+        html_string[ctx->render_cache->length] = '\0';
+        return html_string;
+    }
+
+    html_render_format format;
+    html_resolve_format(&format, options);
+
+    // size the buffer up front so the whole page is a single allocation
+    size_t size = html_render_length_ex(ctx, options);
+
+    html_writer writer;
+    if (!html_writer_init(&writer, size + 1, NULL, NULL))
+        return NULL;
+
+    html_write_doctype(&writer, &format);
+    ctx->indent_level = 0;
+    html_write_tree(&writer, ctx->root, ctx->indent_level, &format);
+    html_writer_putc(&writer, '\0');
+
+    if (writer.error)
+    {
+        html_writer_free(&writer);
+        return NULL;
+    }
+
+    return writer.data;
+}
+
+//////////chunked rendering///////
+
+struct html_render_cursor
+{
+    html_context *ctx;
+    html_render_format format;
+    html_render_stack stack;
+    html_writer pending;
+    size_t offset;
+    int started;
+    int finished;
+};
+
+html_render_cursor *html_render_begin(html_context *ctx)
+{
+    return html_render_begin_ex(ctx, NULL);
+}
+
+html_render_cursor *html_render_begin_ex(html_context *ctx, const html_render_options *options)
+{
+    if (!ctx || !ctx->root)
+    {
+        html_set_error_code(HTML_ERROR_INVALID_ARGUMENT, "Invalid HTML context or root element");
+        return NULL;
+    }
+
+    if (ctx->root->flags & HTML_ELEMENT_STREAM_OPEN)
+    {
+        html_set_error_code(HTML_ERROR_INVALID_STATE, "Document is already being streamed to its output file");
+        return NULL;
+    }
+
+    html_render_cursor *cursor = (html_render_cursor *)malloc(sizeof(html_render_cursor));
+    if (!cursor)
+    {
+        html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for render cursor");
+        return NULL;
+    }
+
+    memset(cursor, 0, sizeof(html_render_cursor));
+    cursor->ctx = ctx;
+    html_resolve_format(&cursor->format, options);
+    html_render_stack_init(&cursor->stack);
+
+    if (!html_writer_init(&cursor->pending, 4096, NULL, NULL))
+    {
+        free(cursor);
+        return NULL;
+    }
+
+    return cursor;
+}
+
+// renders whole tags into the pending buffer until it holds at least wanted bytes
+static int html_render_fill(html_render_cursor *cursor, size_t wanted)
+{
+    html_writer *writer = &cursor->pending;
+
+    if (!cursor->started)
+    {
+        cursor->started = 1;
+        html_write_doctype(writer, &cursor->format);
+        if (!html_write_first(writer, &cursor->stack, cursor->ctx->root, 1, &cursor->format))
+            return 0;
+    }
+
+    while (writer->length < wanted && cursor->stack.depth > 0)
+    {
+        if (!html_write_step(writer, &cursor->stack, 1, &cursor->format))
+            return 0;
+    }
+
+    if (cursor->stack.depth == 0)
+        cursor->finished = 1;
+
+    return !writer->error;
+}
+
+size_t html_render_next_chunk(html_render_cursor *cursor, char *buf, size_t cap)
+{
+    if (!cursor || !buf)
+        return 0;
+
+    html_writer *pending = &cursor->pending;
+    size_t written = 0;
+
+    while (written < cap)
+    {
+        if (cursor->offset < pending->length)
+        {
+            size_t n = pending->length - cursor->offset;
+            if (n > cap - written)
+                n = cap - written;
+
+            memcpy(buf + written, pending->data + cursor->offset, n);
+            cursor->offset += n;
+            written += n;
+            continue;
+        }
+
+        pending->length = 0;
+        cursor->offset = 0;
+
+        if (cursor->finished || pending->error)
+            break;
+
+        if (!html_render_fill(cursor, cap - written))
+        {
+            pending->error = 1;
+            break;
+        }
+    }
+
+    return written;
+}
+
+int html_render_finished(const html_render_cursor *cursor)
+{
+    if (!cursor)
+        return 1;
+
+    return cursor->finished && cursor->offset >= cursor->pending.length;
+}
+
+void html_render_end(html_render_cursor *cursor)
+{
+    if (!cursor)
+        return;
+
+    html_render_stack_free(&cursor->stack);
+    html_writer_free(&cursor->pending);
+    free(cursor);
+}
+
+//////////parallel rendering///////
+
+#ifndef _WIN32
+
+// smallest task worth handing to another thread, in elements
+#define HTML_PARALLEL_MIN_GRAIN 256
+#define HTML_PARALLEL_TASKS_PER_THREAD 16
+
+typedef struct
+{
+    const html_element *element;
+    int next;
+    int index;
+} html_layout_frame;
+
+// elements in render order with their subtree sizes and levels
+typedef struct
+{
+    const html_element **elements;
+    int *sizes;
+    int *levels;
+    int count;
+    int capacity;
+} html_layout;
+
+typedef struct
+{
+    int first;
+    int end;
+    int level;
+    int parallel;
+    int done;
+    html_writer output;
+} html_segment;
+
+typedef struct
+{
+    pthread_mutex_t lock;
+    int begin;
+    int end;
+} html_task_queue;
+
+typedef struct
+{
+    html_layout *layout;
+    html_segment *segments;
+    int *tasks;
+    html_task_queue *queues;
+    int queue_count;
+    html_render_format format;
+    pthread_mutex_t done_lock;
+    pthread_cond_t done_cond;
+} html_parallel_pool;
+
+typedef struct
+{
+    html_parallel_pool *pool;
+    int index;
+} html_parallel_worker;
+
+static int html_render_open(const html_element *element)
+{
+    return element->children_count > 0 && !(element->content && element->content[0]) &&
+           !html_tag_is_self_closing(element->tag);
+}
+
+static int html_layout_add(html_layout *layout, const html_element *element, int level)
+{
+    if (layout->count >= layout->capacity)
+    {
+        int new_capacity = layout->capacity ? layout->capacity * 2 : 1024;
+        const html_element **elements = (const html_element **)realloc(layout->elements, new_capacity * sizeof(html_element *));
+        if (elements)
+            layout->elements = elements;
+        int *sizes = (int *)realloc(layout->sizes, new_capacity * sizeof(int));
+        if (sizes)
+            layout->sizes = sizes;
+        int *levels = (int *)realloc(layout->levels, new_capacity * sizeof(int));
+        if (levels)
+            layout->levels = levels;
+
+        if (!elements || !sizes || !levels)
+        {
+            html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for render layout");
+            return -1;
+        }
+        layout->capacity = new_capacity;
+    }
+
+    layout->elements[layout->count] = element;
+    layout->sizes[layout->count] = 1;
+    layout->levels[layout->count] = level;
+    return layout->count++;
+}
+
+static int html_layout_build(html_layout *layout, const html_element *root, int level)
+{
+    int capacity = 64;
+    int depth = 0;
+    html_layout_frame *frames = (html_layout_frame *)malloc(capacity * sizeof(html_layout_frame));
+    if (!frames)
+    {
+        html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for render layout");
+        return 0;
+    }
+
+    int index = html_layout_add(layout, root, level);
+    if (index < 0)
+    {
+        free(frames);
+        return 0;
+    }
+
+    if (html_render_open(root))
+    {
+        frames[depth].element = root;
+        frames[depth].next = 0;
+        frames[depth].index = index;
+        depth++;
+    }
+
+    while (depth > 0)
+    {
+        html_layout_frame *frame = &frames[depth - 1];
+
+        if (frame->next >= frame->element->children_count)
+        {
+            layout->sizes[frame->index] = layout->count - frame->index;
+            depth--;
+            continue;
+        }
+
+        const html_element *child = frame->element->children[frame->next++];
+        index = html_layout_add(layout, child, level + depth);
+        if (index < 0)
+            break;
+
+        if (!html_render_open(child))
+            continue;
+
+        if (depth >= capacity)
+        {
+            html_layout_frame *grown = (html_layout_frame *)realloc(frames, capacity * 2 * sizeof(html_layout_frame));
+            if (!grown)
+            {
+                html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for render layout");
+                break;
+            }
+            frames = grown;
+            capacity *= 2;
+        }
+
+        frames[depth].element = child;
+        frames[depth].next = 0;
+        frames[depth].index = index;
+        depth++;
+    }
+
+    free(frames);
+    return depth == 0;
+}
+
+static html_segment *html_segment_add(html_segment **segments, int *count, int *capacity)
+{
+    if (*count >= *capacity)
+    {
+        int new_capacity = *capacity ? *capacity * 2 : 64;
+        html_segment *grown = (html_segment *)realloc(*segments, new_capacity * sizeof(html_segment));
+        if (!grown)
+        {
+            html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for render segments");
+            return NULL;
+        }
+        *segments = grown;
+        *capacity = new_capacity;
+    }
+
+    html_segment *segment = &(*segments)[(*count)++];
+    memset(segment, 0, sizeof(html_segment));
+    return segment;
+}
+
+static html_writer *html_serial_output(html_segment **segments, int *count, int *capacity, int *serial)
+{
+    if (*serial < 0)
+    {
+        html_segment *segment = html_segment_add(segments, count, capacity);
+        if (!segment)
+            return NULL;
+
+        if (!html_writer_init(&segment->output, 256, NULL, NULL))
+        {
+            (*count)--;
+            return NULL;
+        }
+
+        segment->done = 1;
+        *serial = *count - 1;
+    }
+
+    return &(*segments)[*serial].output;
+}
+
+// splits the layout into runs of sibling subtrees of at most grain elements;
+// the start and end tags of elements split open are written serially
+static int html_layout_partition(const html_layout *layout, int grain, const html_render_format *format,
+                                 html_segment **segments, int *segment_count)
+{
+    int capacity = 0;
+    int count = 0;
+    int serial = -1;
+    int split_capacity = 64;
+    int depth = 0;
+    int *splits = (int *)malloc(split_capacity * sizeof(int));
+    int result = 1;
+
+    *segments = NULL;
+    if (!splits)
+    {
+        html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for render segments");
+        result = 0;
+    }
+
+    for (int i = 0; result; )
+    {
+        while (depth > 0 && splits[depth - 1] + layout->sizes[splits[depth - 1]] == i)
+        {
+            const html_element *element = layout->elements[splits[--depth]];
+            html_writer *output = html_serial_output(segments, &count, &capacity, &serial);
+            if (!output)
+            {
+                result = 0;
+                break;
+            }
+
+            if (format->minified)
+                html_write_end_minified(output, element);
+            else
+                html_write_end(output, element, html_indent_width(format, layout->levels[splits[depth]]), format);
+        }
+
+        if (!result || i >= layout->count)
+            break;
+
+        const html_element *element = layout->elements[i];
+
+        if (layout->sizes[i] > grain)
+        {
+            html_writer *output = html_serial_output(segments, &count, &capacity, &serial);
+            if (!output)
+            {
+                result = 0;
+                break;
+            }
+
+            if (format->minified)
+                html_write_start_minified(output, element, format);
+            else
+                html_write_start(output, element, html_indent_width(format, layout->levels[i]), format);
+
+            if (depth >= split_capacity)
+            {
+                int *grown = (int *)realloc(splits, split_capacity * 2 * sizeof(int));
+                if (!grown)
+                {
+                    html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for render segments");
+                    result = 0;
+                    break;
+                }
+                splits = grown;
+                split_capacity *= 2;
+            }
+
+            splits[depth++] = i++;
+            continue;
+        }
+
+        // group following siblings into the same task while it stays small
+        int parent_end = depth > 0 ? splits[depth - 1] + layout->sizes[splits[depth - 1]] : layout->count;
+        int end = i + layout->sizes[i];
+        int total = layout->sizes[i];
+        while (end < parent_end && total + layout->sizes[end] <= grain)
+        {
+            total += layout->sizes[end];
+            end += layout->sizes[end];
+        }
+
+        // leftovers next to split elements are not worth a task of their own
+        if (total < grain / 4)
+        {
+            html_writer *output = html_serial_output(segments, &count, &capacity, &serial);
+            for (int k = i; output && k < end; k += layout->sizes[k])
+            {
+                html_write_tree(output, layout->elements[k], layout->levels[k], format);
+            }
+
+            if (!output || output->error)
+            {
+                result = 0;
+                break;
+            }
+
+            i = end;
+            continue;
+        }
+
+        html_segment *segment = html_segment_add(segments, &count, &capacity);
+        if (!segment)
+        {
+            result = 0;
+            break;
+        }
+
+        segment->first = i;
+        segment->end = end;
+        segment->parallel = 1;
+        serial = -1;
+        i = end;
+    }
+
+    free(splits);
+    *segment_count = count;
+    return result;
+}
+
+static void html_render_segment(html_parallel_pool *pool, html_segment *segment)
+{
+    const html_layout *layout = pool->layout;
+    size_t estimate = (size_t)(segment->end - segment->first) * 64;
+    int result = html_writer_init(&segment->output, estimate, NULL, NULL);
+
+    for (int k = segment->first; result && k < segment->end; k += layout->sizes[k])
+    {
+        result = html_write_tree(&segment->output, layout->elements[k], layout->levels[k], &pool->format);
+    }
+
+    if (!result)
+        segment->output.error = 1;
+
+    pthread_mutex_lock(&pool->done_lock);
+    segment->done = 1;
+    pthread_cond_broadcast(&pool->done_cond);
+    pthread_mutex_unlock(&pool->done_lock);
+}
+
+// takes the next task of the worker's own queue, or steals half of another one
+static int html_parallel_take(html_parallel_pool *pool, int index)
+{
+    html_task_queue *own = &pool->queues[index];
+    int task = -1;
+
+    pthread_mutex_lock(&own->lock);
+    if (own->begin < own->end)
+        task = pool->tasks[own->begin++];
+    pthread_mutex_unlock(&own->lock);
+
+    for (int i = 1; task < 0 && i < pool->queue_count; i++)
+    {
+        html_task_queue *victim = &pool->queues[(index + i) % pool->queue_count];
+        int begin = 0;
+        int end = 0;
+
+        pthread_mutex_lock(&victim->lock);
+        int remaining = victim->end - victim->begin;
+        if (remaining > 0)
+        {
+            // thieves take from the back, leaving the owner the tasks it is about to reach
+            int stolen = (remaining + 1) / 2;
+            end = victim->end;
+            begin = end - stolen;
+            victim->end = begin;
+        }
+        pthread_mutex_unlock(&victim->lock);
+
+        if (begin < end)
+        {
+            task = pool->tasks[begin];
+            pthread_mutex_lock(&own->lock);
+            own->begin = begin + 1;
+            own->end = end;
+            pthread_mutex_unlock(&own->lock);
+        }
+    }
+
+    return task;
+}
+
+static void *html_parallel_worker_main(void *arg)
+{
+    html_parallel_worker *worker = (html_parallel_worker *)arg;
+    html_parallel_pool *pool = worker->pool;
+
+    int task;
+    while ((task = html_parallel_take(pool, worker->index)) >= 0)
+    {
+        html_render_segment(pool, &pool->segments[task]);
+    }
+
+    return NULL;
+}
+
+static int html_parallel_write(html_context *ctx, html_parallel_pool *pool, int segment_count)
+{
+    int result = 1;
+
+    for (int i = 0; i < segment_count; i++)
+    {
+        html_segment *segment = &pool->segments[i];
+
+        // the writing thread lends a hand while the next segment is still pending
+        for (;;)
+        {
+            pthread_mutex_lock(&pool->done_lock);
+            int done = segment->done;
+            pthread_mutex_unlock(&pool->done_lock);
+            if (done)
+                break;
+
+            int task = html_parallel_take(pool, 0);
+            if (task >= 0)
+            {
+                html_render_segment(pool, &pool->segments[task]);
+                continue;
+            }
+
+            pthread_mutex_lock(&pool->done_lock);
+            while (!segment->done)
+                pthread_cond_wait(&pool->done_cond, &pool->done_lock);
+            pthread_mutex_unlock(&pool->done_lock);
+        }
+
+        if (segment->output.error)
+            result = 0;
+        else if (result && segment->output.length > 0 &&
+                 !html_flush_output(ctx, segment->output.data, segment->output.length))
+        {
+            html_set_error_code(HTML_ERROR_IO, "failed to write rendered output");
+            result = 0;
+        }
+
+        html_writer_free(&segment->output);
+    }
+
+    return result;
+}
+
+static int html_render_parallel_tree(html_context *ctx, int nthreads)
+{
+    html_parallel_pool pool;
+    html_layout layout;
+    memset(&pool, 0, sizeof(pool));
+    memset(&layout, 0, sizeof(layout));
+
+    pool.layout = &layout;
+    html_resolve_format(&pool.format, NULL);
+
+    int segment_count = 0;
+    int result = html_layout_build(&layout, ctx->root, 1);
+
+    int grain = layout.count / (nthreads * HTML_PARALLEL_TASKS_PER_THREAD);
+    if (grain < HTML_PARALLEL_MIN_GRAIN)
+        grain = HTML_PARALLEL_MIN_GRAIN;
+
+    if (result)
+        result = html_layout_partition(&layout, grain, &pool.format, &pool.segments, &segment_count);
+
+    int task_count = 0;
+    if (result)
+    {
+        pool.tasks = (int *)malloc((segment_count + 1) * sizeof(int));
+        pool.queues = (html_task_queue *)calloc(nthreads, sizeof(html_task_queue));
+        if (!pool.tasks || !pool.queues)
+        {
+            html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for render pool");
+            result = 0;
+        }
+    }
+
+    if (!result)
+    {
+        for (int i = 0; i < segment_count; i++)
+            html_writer_free(&pool.segments[i].output);
+        free(pool.segments);
+        free(pool.tasks);
+        free(pool.queues);
+        free(layout.elements);
+        free(layout.sizes);
+        free(layout.levels);
+        return 0;
+    }
+
+    for (int i = 0; i < segment_count; i++)
+    {
+        if (pool.segments[i].parallel)
+            pool.tasks[task_count++] = i;
+    }
+
+    // contiguous slices keep each worker close to the order the output is written in
+    pool.queue_count = nthreads;
+    for (int i = 0; i < nthreads; i++)
+    {
+        pthread_mutex_init(&pool.queues[i].lock, NULL);
+        pool.queues[i].begin = (int)((long long)task_count * i / nthreads);
+        pool.queues[i].end = (int)((long long)task_count * (i + 1) / nthreads);
+    }
+    pthread_mutex_init(&pool.done_lock, NULL);
+    pthread_cond_init(&pool.done_cond, NULL);
+
+    pthread_t *threads = (pthread_t *)malloc(nthreads * sizeof(pthread_t));
+    html_parallel_worker *workers = (html_parallel_worker *)malloc(nthreads * sizeof(html_parallel_worker));
+    int started = 0;
+
+    // the calling thread is worker 0; a failed thread start only costs parallelism
+    if (threads && workers)
+    {
+        for (int i = 1; i < nthreads; i++)
+        {
+            workers[i].pool = &pool;
+            workers[i].index = i;
+            if (pthread_create(&threads[started], NULL, html_parallel_worker_main, &workers[i]) == 0)
+                started++;
+        }
+    }
+
+    html_writer header;
+    if (html_writer_init(&header, 256, NULL, NULL))
+    {
+        html_write_doctype(&header, &pool.format);
+        if (!html_flush_output(ctx, header.data, header.length))
+            result = 0;
+        html_writer_free(&header);
+    }
+    else
+    {
+        result = 0;
+    }
+
+    if (!html_parallel_write(ctx, &pool, segment_count))
+        result = 0;
+
+    for (int i = 0; i < started; i++)
+        pthread_join(threads[i], NULL);
+
+    for (int i = 0; i < nthreads; i++)
+        pthread_mutex_destroy(&pool.queues[i].lock);
+    pthread_mutex_destroy(&pool.done_lock);
+    pthread_cond_destroy(&pool.done_cond);
+
+    free(threads);
+    free(workers);
+    free(pool.segments);
+    free(pool.tasks);
+    free(pool.queues);
+    free(layout.elements);
+    free(layout.sizes);
+    free(layout.levels);
+    return result;
+}
+
+#endif
+
+int html_render_parallel(html_context *ctx, int nthreads)
+{
+    if (!ctx || !ctx->root || !ctx->sink)
+        return 0;
+
+#ifndef _WIN32
+    if (nthreads > 1 && !(ctx->root->flags & HTML_ELEMENT_STREAM_OPEN))
+    {
+        ctx->indent_level = 1;
+        ctx->rendered = 1;
+        int result = html_render_parallel_tree(ctx, nthreads);
+        return html_sink_flush(ctx->sink) && result;
+    }
+#endif
+
+    return html_render(ctx);
+}
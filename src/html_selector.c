@@ -0,0 +1,713 @@
+#include "HTML.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#define HTML_ATTR_EXISTS 0
+#define HTML_ATTR_EQUALS '='
+#define HTML_ATTR_WORD '~'
+#define HTML_ATTR_PREFIX '^'
+#define HTML_ATTR_SUFFIX '$'
+#define HTML_ATTR_SUBSTRING '*'
+#define HTML_ATTR_DASH '|'
+
+typedef struct
+{
+    char *name;
+    char *value;
+    int op;
+} html_selector_attr;
+
+typedef struct
+{
+    // -1 matches any tag
+    int tag;
+    char *id;
+    char **classes;
+    int class_count;
+    html_selector_attr *attrs;
+    int attr_count;
+    // relation to the compound on its left: ' ', '>', '+', '~' or 0 for the first one
+    char combinator;
+} html_compound;
+
+typedef struct
+{
+    html_compound *compounds;
+    int count;
+} html_complex_selector;
+
+struct html_selector
+{
+    html_complex_selector *selectors;
+    int count;
+    // longest complex selector, sizes the backtracking stack
+    int max_compounds;
+};
+
+typedef struct
+{
+    int index;
+    const html_element *element;
+} html_match_choice;
+
+//////////////compiling///////////////////////
+
+static int html_is_ident_char(unsigned char c)
+{
+    return isalnum(c) || c == '-' || c == '_' || c >= 0x80;
+}
+
+static char *html_parse_ident(const char **cursor)
+{
+    const char *start = *cursor;
+    while (html_is_ident_char((unsigned char)**cursor))
+        (*cursor)++;
+
+    size_t len = *cursor - start;
+    if (len == 0)
+        return NULL;
+
+    char *ident = (char *)malloc(len + 1);
+    if (!ident)
+    {
+        html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for selector");
+        return NULL;
+    }
+    memcpy(ident, start, len);
+    ident[len] = '\0';
+    return ident;
+}
+
+static char *html_parse_attr_value(const char **cursor)
+{
+    char quote = **cursor;
+    if (quote != '"' && quote != '\'')
+        return html_parse_ident(cursor);
+
+    const char *start = ++(*cursor);
+    const char *end = strchr(start, quote);
+    if (!end)
+        return NULL;
+
+    size_t len = end - start;
+    char *value = (char *)malloc(len + 1);
+    if (!value)
+    {
+        html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for selector");
+        return NULL;
+    }
+    memcpy(value, start, len);
+    value[len] = '\0';
+    *cursor = end + 1;
+    return value;
+}
+
+static void html_skip_spaces(const char **cursor)
+{
+    while (isspace((unsigned char)**cursor))
+        (*cursor)++;
+}
+
+static void html_free_compound(html_compound *compound)
+{
+    free(compound->id);
+    for (int i = 0; i < compound->class_count; i++)
+        free(compound->classes[i]);
+    free(compound->classes);
+    for (int i = 0; i < compound->attr_count; i++)
+    {
+        free(compound->attrs[i].name);
+        free(compound->attrs[i].value);
+    }
+    free(compound->attrs);
+}
+
+static int html_parse_attr_selector(const char **cursor, html_compound *compound)
+{
+    html_selector_attr attr = {0};
+
+    (*cursor)++;
+    html_skip_spaces(cursor);
+    attr.name = html_parse_ident(cursor);
+    if (!attr.name)
+        return 0;
+    html_skip_spaces(cursor);
+
+    if (**cursor == '=')
+    {
+        attr.op = HTML_ATTR_EQUALS;
+        (*cursor)++;
+    }
+    else if (**cursor && strchr("~^$*|", **cursor) && (*cursor)[1] == '=')
+    {
+        attr.op = **cursor;
+        *cursor += 2;
+    }
+
+    if (attr.op != HTML_ATTR_EXISTS)
+    {
+        html_skip_spaces(cursor);
+        attr.value = html_parse_attr_value(cursor);
+        if (!attr.value)
+        {
+            free(attr.name);
+            return 0;
+        }
+        html_skip_spaces(cursor);
+    }
+
+    if (**cursor != ']')
+    {
+        free(attr.name);
+        free(attr.value);
+        return 0;
+    }
+    (*cursor)++;
+
+    html_selector_attr *attrs = (html_selector_attr *)realloc(compound->attrs, (compound->attr_count + 1) * sizeof(html_selector_attr));
+    if (!attrs)
+    {
+        free(attr.name);
+        free(attr.value);
+        return 0;
+    }
+    compound->attrs = attrs;
+    compound->attrs[compound->attr_count++] = attr;
+    return 1;
+}
+
+static int html_parse_compound(const char **cursor, html_compound *compound)
+{
+    memset(compound, 0, sizeof(*compound));
+    compound->tag = -1;
+    int parts = 0;
+
+    if (**cursor == '*')
+    {
+        (*cursor)++;
+        parts++;
+    }
+    else if (html_is_ident_char((unsigned char)**cursor))
+    {
+        char *name = html_parse_ident(cursor);
+        if (!name)
+            return 0;
+        // interned so the compiled selector keeps matching documents built later
+        compound->tag = html_tag_intern(name);
+        free(name);
+        if (compound->tag < 0)
+            return 0;
+        parts++;
+    }
+
+    for (;;)
+    {
+        char c = **cursor;
+        if (c == '#')
+        {
+            (*cursor)++;
+            char *id = html_parse_ident(cursor);
+            if (!id)
+                return 0;
+            free(compound->id);
+            compound->id = id;
+        }
+        else if (c == '.')
+        {
+            (*cursor)++;
+            char *classname = html_parse_ident(cursor);
+            if (!classname)
+                return 0;
+
+            char **classes = (char **)realloc(compound->classes, (compound->class_count + 1) * sizeof(char *));
+            if (!classes)
+            {
+                free(classname);
+                return 0;
+            }
+            compound->classes = classes;
+            compound->classes[compound->class_count++] = classname;
+        }
+        else if (c == '[')
+        {
+            if (!html_parse_attr_selector(cursor, compound))
+                return 0;
+        }
+        else
+        {
+            break;
+        }
+        parts++;
+    }
+
+    return parts > 0;
+}
+
+static int html_parse_complex(const char **cursor, html_complex_selector *complex)
+{
+    memset(complex, 0, sizeof(*complex));
+    char combinator = 0;
+
+    for (;;)
+    {
+        html_compound *compounds = (html_compound *)realloc(complex->compounds, (complex->count + 1) * sizeof(html_compound));
+        if (!compounds)
+            return 0;
+        complex->compounds = compounds;
+
+        html_compound *compound = &complex->compounds[complex->count];
+        int ok = html_parse_compound(cursor, compound);
+        complex->count++;
+        if (!ok)
+            return 0;
+        compound->combinator = combinator;
+
+        const char *before = *cursor;
+        html_skip_spaces(cursor);
+        char c = **cursor;
+        if (c == '>' || c == '+' || c == '~')
+        {
+            combinator = c;
+            (*cursor)++;
+            html_skip_spaces(cursor);
+        }
+        else if (c == ',' || c == '\0')
+        {
+            return 1;
+        }
+        else if (*cursor != before)
+        {
+            combinator = ' ';
+        }
+        else
+        {
+            return 0;
+        }
+    }
+}
+
+void html_selector_free(html_selector *selector)
+{
+    if (!selector)
+        return;
+
+    for (int i = 0; i < selector->count; i++)
+    {
+        for (int j = 0; j < selector->selectors[i].count; j++)
+            html_free_compound(&selector->selectors[i].compounds[j]);
+        free(selector->selectors[i].compounds);
+    }
+    free(selector->selectors);
+    free(selector);
+}
+
+html_selector *html_selector_compile(const char *text)
+{
+    if (!text)
+    {
+        html_set_error_code(HTML_ERROR_INVALID_ARGUMENT, "Selector cannot be NULL");
+        return NULL;
+    }
+
+    html_selector *selector = (html_selector *)calloc(1, sizeof(html_selector));
+    if (!selector)
+    {
+        html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for selector");
+        return NULL;
+    }
+
+    const char *cursor = text;
+    for (;;)
+    {
+        html_skip_spaces(&cursor);
+
+        html_complex_selector *selectors = (html_complex_selector *)realloc(selector->selectors, (selector->count + 1) * sizeof(html_complex_selector));
+        if (!selectors)
+        {
+            html_selector_free(selector);
+            html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for selector");
+            return NULL;
+        }
+        selector->selectors = selectors;
+
+        int ok = html_parse_complex(&cursor, &selector->selectors[selector->count]);
+        selector->count++;
+        if (!ok)
+        {
+            html_selector_free(selector);
+            html_set_error_ex(HTML_ERROR_INVALID_ARGUMENT, "Invalid selector '%s' near offset %d", text,
+                              (int)(cursor - text));
+            return NULL;
+        }
+
+        if (selector->selectors[selector->count - 1].count > selector->max_compounds)
+            selector->max_compounds = selector->selectors[selector->count - 1].count;
+
+        if (*cursor != ',')
+            break;
+        cursor++;
+    }
+
+    return selector;
+}
+
+//////////////matching///////////////////////
+
+static int html_match_attr(const html_selector_attr *attr, const html_element *element)
+{
+    const char *value = html_get_element_attribute(element, attr->name);
+    if (!value)
+        return 0;
+
+    size_t len = strlen(value);
+    size_t want = attr->value ? strlen(attr->value) : 0;
+
+    switch (attr->op)
+    {
+    case HTML_ATTR_EXISTS:
+        return 1;
+    case HTML_ATTR_EQUALS:
+        return strcmp(value, attr->value) == 0;
+    case HTML_ATTR_PREFIX:
+        return want > 0 && strncmp(value, attr->value, want) == 0;
+    case HTML_ATTR_SUFFIX:
+        return want > 0 && len >= want && strcmp(value + len - want, attr->value) == 0;
+    case HTML_ATTR_SUBSTRING:
+        return want > 0 && strstr(value, attr->value) != NULL;
+    case HTML_ATTR_DASH:
+        return strncmp(value, attr->value, want) == 0 && (value[want] == '\0' || value[want] == '-');
+    case HTML_ATTR_WORD:
+    {
+        const char *cursor = value;
+        while (want > 0 && *cursor)
+        {
+            while (isspace((unsigned char)*cursor))
+                cursor++;
+            const char *start = cursor;
+            while (*cursor && !isspace((unsigned char)*cursor))
+                cursor++;
+            if ((size_t)(cursor - start) == want && memcmp(start, attr->value, want) == 0)
+                return 1;
+        }
+        return 0;
+    }
+    }
+
+    return 0;
+}
+
+static int html_match_compound(const html_compound *compound, const html_element *element)
+{
+    if (compound->tag >= 0 && element->tag != compound->tag)
+        return 0;
+
+    if (compound->id && (!element->id || strcmp(element->id, compound->id) != 0))
+        return 0;
+
+    for (int i = 0; i < compound->class_count; i++)
+    {
+        if (!html_has_class(element, compound->classes[i]))
+            return 0;
+    }
+
+    for (int i = 0; i < compound->attr_count; i++)
+    {
+        if (!html_match_attr(&compound->attrs[i], element))
+            return 0;
+    }
+
+    return 1;
+}
+
+static const html_element *html_previous_sibling(const html_element *element)
+{
+    const html_element *parent = element->parent;
+    if (!parent)
+        return NULL;
+
+    for (int i = 1; i < parent->children_count; i++)
+    {
+        if (parent->children[i] == element)
+            return parent->children[i - 1];
+    }
+
+    return NULL;
+}
+
+// walks from 'from' in the direction of the combinator looking for a match of compound
+static const html_element *html_find_related(const html_compound *compound, char combinator, const html_element *from)
+{
+    const html_element *candidate = combinator == '~' ? html_previous_sibling(from) : from->parent;
+    while (candidate)
+    {
+        if (html_match_compound(compound, candidate))
+            return candidate;
+        candidate = combinator == '~' ? html_previous_sibling(candidate) : candidate->parent;
+    }
+
+    return NULL;
+}
+
+static int html_match_complex(const html_complex_selector *complex, const html_element *element, html_match_choice *choices)
+{
+    int index = complex->count - 1;
+    if (!html_match_compound(&complex->compounds[index], element))
+        return 0;
+
+    // choice points for ' ' and '~' combinators, resumed when a later step fails
+    int depth = 0;
+    const html_element *current = element;
+
+    while (index > 0)
+    {
+        char combinator = complex->compounds[index].combinator;
+        const html_compound *target = &complex->compounds[index - 1];
+        const html_element *next = NULL;
+
+        if (combinator == '>')
+        {
+            next = current->parent && html_match_compound(target, current->parent) ? current->parent : NULL;
+        }
+        else if (combinator == '+')
+        {
+            const html_element *previous = html_previous_sibling(current);
+            next = previous && html_match_compound(target, previous) ? previous : NULL;
+        }
+        else
+        {
+            next = html_find_related(target, combinator, current);
+            if (next)
+            {
+                choices[depth].index = index;
+                choices[depth].element = next;
+                depth++;
+            }
+        }
+
+        while (!next)
+        {
+            if (depth == 0)
+                return 0;
+
+            html_match_choice *choice = &choices[depth - 1];
+            index = choice->index;
+            combinator = complex->compounds[index].combinator;
+            next = html_find_related(&complex->compounds[index - 1], combinator, choice->element);
+            if (next)
+                choice->element = next;
+            else
+                depth--;
+        }
+
+        current = next;
+        index--;
+    }
+
+    return 1;
+}
+
+int html_selector_matches(const html_selector *selector, const html_element *element)
+{
+    if (!selector || !element)
+        return 0;
+
+    html_match_choice stack_choices[16];
+    html_match_choice *choices = stack_choices;
+    if (selector->max_compounds > 16)
+        choices = (html_match_choice *)malloc(selector->max_compounds * sizeof(html_match_choice));
+    if (!choices)
+    {
+        html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for selector matching");
+        return 0;
+    }
+
+    int matched = 0;
+    for (int i = 0; i < selector->count && !matched; i++)
+    {
+        matched = html_match_complex(&selector->selectors[i], element, choices);
+    }
+
+    if (choices != stack_choices)
+        free(choices);
+    return matched;
+}
+
+//////////////querying///////////////////////
+
+// finds the element whose subtree must contain every match, using the ID index
+static int html_selector_scope(html_context *ctx, const html_selector *selector, html_element **scope, int *single)
+{
+    *scope = ctx->root;
+    *single = 0;
+
+    if (selector->count != 1)
+        return 1;
+
+    const html_complex_selector *complex = &selector->selectors[0];
+    const html_compound *last = &complex->compounds[complex->count - 1];
+    if (last->id)
+    {
+        *scope = html_get_element_by_id(ctx, last->id);
+        *single = 1;
+        return *scope != NULL;
+    }
+
+    for (int i = complex->count - 2; i >= 0; i--)
+    {
+        // sibling combinators to the right could leave the subtree of an ID match
+        char combinator = complex->compounds[i + 1].combinator;
+        if (combinator == '+' || combinator == '~')
+            break;
+
+        if (complex->compounds[i].id)
+        {
+            *scope = html_get_element_by_id(ctx, complex->compounds[i].id);
+            return *scope != NULL;
+        }
+    }
+
+    return 1;
+}
+
+static int html_collect(html_element ***results, int *count, int *capacity, html_element *element)
+{
+    if (*count >= *capacity)
+    {
+        int new_capacity = *capacity ? *capacity * 2 : 16;
+        html_element **grown = (html_element **)realloc(*results, new_capacity * sizeof(html_element *));
+        if (!grown)
+        {
+            html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for selector results");
+            return 0;
+        }
+        *results = grown;
+        *capacity = new_capacity;
+    }
+
+    (*results)[(*count)++] = element;
+    return 1;
+}
+
+static html_element **html_selector_run(html_context *ctx, const html_selector *selector, int *count, int limit)
+{
+    *count = 0;
+
+    if (!ctx || !ctx->root || !selector)
+        return NULL;
+
+    html_element *scope;
+    int single;
+    if (!html_selector_scope(ctx, selector, &scope, &single))
+        return NULL;
+
+    html_element **results = NULL;
+    int capacity = 0;
+
+    if (single)
+    {
+        if (html_selector_matches(selector, scope))
+            html_collect(&results, count, &capacity, scope);
+        return results;
+    }
+
+    // pre-order walk with an explicit stack, children pushed in reverse
+    int stack_capacity = 64;
+    int top = 0;
+    html_element **stack = (html_element **)malloc(stack_capacity * sizeof(html_element *));
+    if (!stack)
+    {
+        html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for selector traversal");
+        return NULL;
+    }
+
+    for (int i = scope->children_count - 1; i >= 0; i--)
+    {
+        if (top >= stack_capacity)
+        {
+            stack_capacity *= 2;
+            html_element **grown = (html_element **)realloc(stack, stack_capacity * sizeof(html_element *));
+            if (!grown)
+                goto fail;
+            stack = grown;
+        }
+        stack[top++] = scope->children[i];
+    }
+    if (scope == ctx->root && html_selector_matches(selector, scope) && !html_collect(&results, count, &capacity, scope))
+        goto fail;
+
+    while (top > 0 && (limit <= 0 || *count < limit))
+    {
+        html_element *element = stack[--top];
+
+        if (html_selector_matches(selector, element) && !html_collect(&results, count, &capacity, element))
+            goto fail;
+
+        if (top + element->children_count > stack_capacity)
+        {
+            while (top + element->children_count > stack_capacity)
+                stack_capacity *= 2;
+            html_element **grown = (html_element **)realloc(stack, stack_capacity * sizeof(html_element *));
+            if (!grown)
+                goto fail;
+            stack = grown;
+        }
+
+        for (int i = element->children_count - 1; i >= 0; i--)
+            stack[top++] = element->children[i];
+    }
+
+    free(stack);
+    return results;
+
+fail:
+    html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for selector traversal");
+    free(stack);
+    free(results);
+    *count = 0;
+    return NULL;
+}
+
+html_element **html_selector_query_all(html_context *ctx, const html_selector *selector, int *count)
+{
+    int found = 0;
+    html_element **results = html_selector_run(ctx, selector, &found, 0);
+    if (count)
+        *count = found;
+    return results;
+}
+
+html_element *html_selector_query(html_context *ctx, const html_selector *selector)
+{
+    int found = 0;
+    html_element **results = html_selector_run(ctx, selector, &found, 1);
+    html_element *first = found > 0 ? results[0] : NULL;
+    free(results);
+    return first;
+}
+
+html_element **html_query_selector_all(html_context *ctx, const char *selector, int *count)
+{
+    if (count)
+        *count = 0;
+
+    html_selector *compiled = html_selector_compile(selector);
+    if (!compiled)
+        return NULL;
+
+    html_element **results = html_selector_query_all(ctx, compiled, count);
+    html_selector_free(compiled);
+    return results;
+}
+
+html_element *html_query_selector(html_context *ctx, const char *selector)
+{
+    html_selector *compiled = html_selector_compile(selector);
+    if (!compiled)
+        return NULL;
+
+    html_element *result = html_selector_query(ctx, compiled);
+    html_selector_free(compiled);
+    return result;
+}
@@ -0,0 +1,341 @@
+#include "HTML.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#include <pthread.h>
+#endif
+
+html_sink *html_sink_create(const html_sink_ops *ops, void *state)
+{
+    if (!ops || !ops->write)
+    {
+        html_set_error_code(HTML_ERROR_INVALID_ARGUMENT, "Sink needs a write operation");
+        return NULL;
+    }
+
+    html_sink *sink = (html_sink *)malloc(sizeof(html_sink));
+    if (!sink)
+    {
+        html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for output sink");
+        return NULL;
+    }
+
+    sink->ops = ops;
+    sink->state = state;
+    return sink;
+}
+
+int html_sink_write(void *target, const char *data, size_t len)
+{
+    html_sink *sink = (html_sink *)target;
+    return sink->ops->write(sink->state, data, len);
+}
+
+int html_sink_flush(html_sink *sink)
+{
+    if (!sink)
+        return 0;
+
+    if (sink->ops->flush && !sink->ops->flush(sink->state))
+    {
+        html_set_error_code(HTML_ERROR_IO, "failed to flush rendered output");
+        return 0;
+    }
+    return 1;
+}
+
+void html_sink_close(html_sink *sink)
+{
+    if (!sink)
+        return;
+
+    if (sink->ops->close)
+        sink->ops->close(sink->state);
+    free(sink);
+}
+
+//////////file and descriptor sinks///////
+
+static int html_file_sink_write(void *state, const char *data, size_t len)
+{
+    return fwrite(data, 1, len, (FILE *)state) == len;
+}
+
+static int html_file_sink_flush(void *state)
+{
+    return fflush((FILE *)state) == 0;
+}
+
+static void html_file_sink_close(void *state)
+{
+    fclose((FILE *)state);
+}
+
+static void html_file_sink_release(void *state)
+{
+    fflush((FILE *)state);
+}
+
+static const html_sink_ops html_file_sink_ops = {
+    html_file_sink_write,
+    html_file_sink_flush,
+    html_file_sink_close,
+};
+
+static const html_sink_ops html_borrowed_file_sink_ops = {
+    html_file_sink_write,
+    html_file_sink_flush,
+    html_file_sink_release,
+};
+
+html_sink *html_sink_file(FILE *file, int close_file)
+{
+    if (!file)
+    {
+        html_set_error_code(HTML_ERROR_INVALID_ARGUMENT, "Sink file cannot be NULL");
+        return NULL;
+    }
+
+    return html_sink_create(close_file ? &html_file_sink_ops : &html_borrowed_file_sink_ops, file);
+}
+
+static int html_fd_sink_write(void *state, const char *data, size_t len)
+{
+    return html_write_fd((int)(intptr_t)state, data, len);
+}
+
+static void html_fd_sink_close(void *state)
+{
+#ifdef _WIN32
+    _close((int)(intptr_t)state);
+#else
+    close((int)(intptr_t)state);
+#endif
+}
+
+static const html_sink_ops html_fd_sink_ops = {
+    html_fd_sink_write,
+    NULL,
+    html_fd_sink_close,
+};
+
+static const html_sink_ops html_borrowed_fd_sink_ops = {
+    html_fd_sink_write,
+    NULL,
+    NULL,
+};
+
+html_sink *html_sink_fd(int fd, int close_fd)
+{
+    if (fd < 0)
+    {
+        html_set_error_code(HTML_ERROR_INVALID_ARGUMENT, "Invalid sink file descriptor");
+        return NULL;
+    }
+
+    return html_sink_create(close_fd ? &html_fd_sink_ops : &html_borrowed_fd_sink_ops, (void *)(intptr_t)fd);
+}
+
+//////////asynchronous sink///////
+
+#ifndef _WIN32
+
+// two buffers: the caller fills one while the writer thread drains the other
+typedef struct
+{
+    html_sink *inner;
+    char *buffers[2];
+    size_t capacity;
+    char *current;
+    size_t length;
+    char *pending;
+    size_t pending_length;
+    int stop;
+    int error;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} html_async_sink;
+
+static void *html_async_sink_main(void *arg)
+{
+    html_async_sink *async = (html_async_sink *)arg;
+
+    pthread_mutex_lock(&async->lock);
+    for (;;)
+    {
+        while (!async->pending && !async->stop)
+            pthread_cond_wait(&async->cond, &async->lock);
+
+        if (!async->pending)
+            break;
+
+        char *data = async->pending;
+        size_t len = async->pending_length;
+        pthread_mutex_unlock(&async->lock);
+
+        int ok = async->error ? 0 : html_sink_write(async->inner, data, len);
+
+        pthread_mutex_lock(&async->lock);
+        if (!ok)
+            async->error = 1;
+        async->pending = NULL;
+        pthread_cond_broadcast(&async->cond);
+    }
+    pthread_mutex_unlock(&async->lock);
+    return NULL;
+}
+
+// waits for the writer thread to go idle; the lock must be held
+static int html_async_sink_wait(html_async_sink *async)
+{
+    while (async->pending)
+        pthread_cond_wait(&async->cond, &async->lock);
+    return !async->error;
+}
+
+static int html_async_sink_hand_off(html_async_sink *async)
+{
+    pthread_mutex_lock(&async->lock);
+    int ok = html_async_sink_wait(async);
+    if (ok)
+    {
+        async->pending = async->current;
+        async->pending_length = async->length;
+        pthread_cond_broadcast(&async->cond);
+    }
+    pthread_mutex_unlock(&async->lock);
+
+    if (!ok)
+        return 0;
+
+    async->current = async->current == async->buffers[0] ? async->buffers[1] : async->buffers[0];
+    async->length = 0;
+    return 1;
+}
+
+static int html_async_sink_write(void *state, const char *data, size_t len)
+{
+    html_async_sink *async = (html_async_sink *)state;
+
+    while (len > 0)
+    {
+        size_t room = async->capacity - async->length;
+        size_t chunk = len < room ? len : room;
+
+        memcpy(async->current + async->length, data, chunk);
+        async->length += chunk;
+        data += chunk;
+        len -= chunk;
+
+        if (async->length == async->capacity && !html_async_sink_hand_off(async))
+            return 0;
+    }
+    return 1;
+}
+
+static int html_async_sink_flush(void *state)
+{
+    html_async_sink *async = (html_async_sink *)state;
+
+    if (async->length > 0 && !html_async_sink_hand_off(async))
+        return 0;
+
+    pthread_mutex_lock(&async->lock);
+    int ok = html_async_sink_wait(async);
+    pthread_mutex_unlock(&async->lock);
+
+    return ok && html_sink_flush(async->inner);
+}
+
+static void html_async_sink_close(void *state)
+{
+    html_async_sink *async = (html_async_sink *)state;
+
+    html_async_sink_flush(async);
+
+    pthread_mutex_lock(&async->lock);
+    async->stop = 1;
+    pthread_cond_broadcast(&async->cond);
+    pthread_mutex_unlock(&async->lock);
+    pthread_join(async->thread, NULL);
+
+    pthread_mutex_destroy(&async->lock);
+    pthread_cond_destroy(&async->cond);
+    html_sink_close(async->inner);
+    free(async->buffers[0]);
+    free(async->buffers[1]);
+    free(async);
+}
+
+static const html_sink_ops html_async_sink_ops = {
+    html_async_sink_write,
+    html_async_sink_flush,
+    html_async_sink_close,
+};
+
+html_sink *html_sink_async(html_sink *inner, size_t buffer_size)
+{
+    if (!inner)
+        return NULL;
+
+    if (buffer_size == 0)
+        buffer_size = HTML_SINK_ASYNC_BUFFER_SIZE;
+
+    html_async_sink *async = (html_async_sink *)calloc(1, sizeof(html_async_sink));
+    if (!async)
+    {
+        html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for output sink");
+        html_sink_close(inner);
+        return NULL;
+    }
+
+    async->inner = inner;
+    async->capacity = buffer_size;
+    async->buffers[0] = (char *)malloc(buffer_size);
+    async->buffers[1] = (char *)malloc(buffer_size);
+    async->current = async->buffers[0];
+
+    if (!async->buffers[0] || !async->buffers[1])
+    {
+        html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for output sink");
+        free(async->buffers[0]);
+        free(async->buffers[1]);
+        free(async);
+        html_sink_close(inner);
+        return NULL;
+    }
+
+    pthread_mutex_init(&async->lock, NULL);
+    pthread_cond_init(&async->cond, NULL);
+
+    if (pthread_create(&async->thread, NULL, html_async_sink_main, async) != 0)
+    {
+        // no writer thread: the inner sink still works, just synchronously
+        pthread_mutex_destroy(&async->lock);
+        pthread_cond_destroy(&async->cond);
+        free(async->buffers[0]);
+        free(async->buffers[1]);
+        free(async);
+        return inner;
+    }
+
+    html_sink *sink = html_sink_create(&html_async_sink_ops, async);
+    if (!sink)
+        html_async_sink_close(async);
+    return sink;
+}
+
+#else
+
+html_sink *html_sink_async(html_sink *inner, size_t buffer_size)
+{
+    (void)buffer_size;
+    return inner;
+}
+
+#endif
@@ -0,0 +1,268 @@
+#include "HTML.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+// control bytes: high bit set means the slot holds no key, otherwise the low
+// 7 bits are a fragment of the key hash used to filter candidates
+#define HTML_CTRL_EMPTY 0x80
+#define HTML_CTRL_DELETED 0xFE
+#define HTML_TABLE_GROUP 8
+
+static const uint64_t html_group_lsbs = 0x0101010101010101ULL;
+static const uint64_t html_group_msbs = 0x8080808080808080ULL;
+
+static uint64_t html_load_group(const unsigned char *ctrl)
+{
+    uint64_t group;
+    memcpy(&group, ctrl, sizeof(group));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    group = __builtin_bswap64(group);
+#endif
+    return group;
+}
+
+static int html_lowest_byte(uint64_t mask)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(mask) >> 3;
+#else
+    int index = 0;
+    while (!(mask & 0x80))
+    {
+        mask >>= 8;
+        index++;
+    }
+    return index;
+#endif
+}
+
+static uint64_t html_group_match(uint64_t group, unsigned char h2)
+{
+    uint64_t x = group ^ (html_group_lsbs * h2);
+    return (x - html_group_lsbs) & ~x & html_group_msbs;
+}
+
+static uint64_t html_group_match_empty(uint64_t group)
+{
+    return group & ~(group << 6) & html_group_msbs;
+}
+
+static uint64_t html_group_match_free(uint64_t group)
+{
+    return group & ~(group << 7) & html_group_msbs;
+}
+
+static void html_table_set_ctrl(html_table *table, int index, unsigned char value)
+{
+    table->ctrl[index] = value;
+    // the first group is mirrored past the end so unaligned group loads never wrap
+    if (index < HTML_TABLE_GROUP)
+        table->ctrl[table->capacity + index] = value;
+}
+
+static int html_table_alloc(html_table *table, int capacity)
+{
+    table->ctrl = (unsigned char *)malloc(capacity + HTML_TABLE_GROUP);
+    table->keys = (const char **)calloc(capacity, sizeof(char *));
+    table->values = (void **)calloc(capacity, sizeof(void *));
+
+    if (!table->ctrl || !table->keys || !table->values)
+    {
+        free(table->ctrl);
+        free(table->keys);
+        free(table->values);
+        table->ctrl = NULL;
+        table->keys = NULL;
+        table->values = NULL;
+        html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for hash table");
+        return 0;
+    }
+
+    memset(table->ctrl, HTML_CTRL_EMPTY, capacity + HTML_TABLE_GROUP);
+    table->capacity = capacity;
+    table->size = 0;
+    table->tombstones = 0;
+    return 1;
+}
+
+html_table *html_table_create(int initial_capacity)
+{
+    int capacity = HTML_TABLE_GROUP;
+    while (capacity < initial_capacity)
+        capacity *= 2;
+
+    html_table *table = (html_table *)malloc(sizeof(html_table));
+    if (!table)
+    {
+        html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for hash table");
+        return NULL;
+    }
+
+    if (!html_table_alloc(table, capacity))
+    {
+        free(table);
+        return NULL;
+    }
+
+    return table;
+}
+
+void html_table_free(html_table *table)
+{
+    if (!table)
+        return;
+
+    free(table->ctrl);
+    free(table->keys);
+    free(table->values);
+    free(table);
+}
+
+void html_table_clear(html_table *table)
+{
+    if (!table)
+        return;
+
+    memset(table->ctrl, HTML_CTRL_EMPTY, table->capacity + HTML_TABLE_GROUP);
+    memset(table->keys, 0, table->capacity * sizeof(char *));
+    memset(table->values, 0, table->capacity * sizeof(void *));
+    table->size = 0;
+    table->tombstones = 0;
+}
+
+static int html_table_find_slot(const html_table *table, const char *key, uint64_t hash)
+{
+    unsigned int mask = (unsigned int)table->capacity - 1;
+    unsigned int pos = (unsigned int)(hash >> 7) & mask;
+    unsigned char h2 = (unsigned char)(hash & 0x7F);
+
+    for (unsigned int step = 0; step <= mask; step += HTML_TABLE_GROUP)
+    {
+        uint64_t group = html_load_group(table->ctrl + pos);
+
+        uint64_t matches = html_group_match(group, h2);
+        while (matches)
+        {
+            int index = (int)((pos + html_lowest_byte(matches)) & mask);
+            if (strcmp(table->keys[index], key) == 0)
+                return index;
+            matches &= matches - 1;
+        }
+
+        if (html_group_match_empty(group))
+            return -1;
+
+        pos = (pos + step + HTML_TABLE_GROUP) & mask;
+    }
+
+    return -1;
+}
+
+static int html_table_free_slot(const html_table *table, uint64_t hash)
+{
+    unsigned int mask = (unsigned int)table->capacity - 1;
+    unsigned int pos = (unsigned int)(hash >> 7) & mask;
+
+    for (unsigned int step = 0;; step += HTML_TABLE_GROUP)
+    {
+        uint64_t group = html_load_group(table->ctrl + pos);
+        uint64_t free_slots = html_group_match_free(group);
+        if (free_slots)
+            return (int)((pos + html_lowest_byte(free_slots)) & mask);
+
+        pos = (pos + step + HTML_TABLE_GROUP) & mask;
+    }
+}
+
+static int html_table_rehash(html_table *table, int new_capacity)
+{
+    html_table old = *table;
+
+    if (!html_table_alloc(table, new_capacity))
+    {
+        *table = old;
+        return 0;
+    }
+
+    for (int i = 0; i < old.capacity; i++)
+    {
+        if (old.ctrl[i] & HTML_CTRL_EMPTY)
+            continue;
+
+        uint64_t hash = html_hash_bytes(old.keys[i], strlen(old.keys[i]));
+        int index = html_table_free_slot(table, hash);
+        html_table_set_ctrl(table, index, (unsigned char)(hash & 0x7F));
+        table->keys[index] = old.keys[i];
+        table->values[index] = old.values[i];
+        table->size++;
+    }
+
+    free(old.ctrl);
+    free(old.keys);
+    free(old.values);
+    return 1;
+}
+
+void *html_table_get(const html_table *table, const char *key)
+{
+    if (!table || !key)
+        return NULL;
+
+    int index = html_table_find_slot(table, key, html_hash_bytes(key, strlen(key)));
+    return index < 0 ? NULL : table->values[index];
+}
+
+int html_table_insert(html_table *table, const char *key, void *value)
+{
+    if (!table || !key)
+        return -1;
+
+    uint64_t hash = html_hash_bytes(key, strlen(key));
+    if (html_table_find_slot(table, key, hash) >= 0)
+        return 0;
+
+    if ((table->size + table->tombstones + 1) * 8 > table->capacity * 7)
+    {
+        // mostly tombstones: clean up in place instead of growing
+        int new_capacity = table->size * 2 < table->capacity ? table->capacity : table->capacity * 2;
+        if (!html_table_rehash(table, new_capacity))
+            return -1;
+    }
+
+    int index = html_table_free_slot(table, hash);
+    if (table->ctrl[index] == HTML_CTRL_DELETED)
+        table->tombstones--;
+
+    html_table_set_ctrl(table, index, (unsigned char)(hash & 0x7F));
+    table->keys[index] = key;
+    table->values[index] = value;
+    table->size++;
+    return 1;
+}
+
+int html_table_remove(html_table *table, const char *key, const void *value)
+{
+    if (!table || !key)
+        return 0;
+
+    int index = html_table_find_slot(table, key, html_hash_bytes(key, strlen(key)));
+    if (index < 0 || (value && table->values[index] != value))
+        return 0;
+
+    html_table_set_ctrl(table, index, HTML_CTRL_DELETED);
+    table->keys[index] = NULL;
+    table->values[index] = NULL;
+    table->size--;
+    table->tombstones++;
+    return 1;
+}
+
+int html_table_grow(html_table *table)
+{
+    if (!table)
+        return 0;
+
+    return html_table_rehash(table, table->capacity * 2);
+}
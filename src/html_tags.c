@@ -0,0 +1,218 @@
+#include "HTML.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HTML_TAG_FLAG_BLOCK 0x1
+#define HTML_TAG_FLAG_VOID 0x2
+#define HTML_TAG_FLAG_HEAD_CONTENT 0x4
+#define HTML_TAG_FLAG_TABLE_CONTENT 0x8
+#define HTML_TAG_FLAG_ROW_CONTENT 0x10
+#define HTML_TAG_FLAG_LIST_CONTENT 0x20
+
+typedef struct
+{
+    const char *name;
+    unsigned char flags;
+    // content flag a child needs to be accepted by this tag, 0 accepts anything
+    unsigned char accepts;
+} html_tag_info;
+
+// sorted by name so lookups can binary search, indexed by html_tag
+static const html_tag_info known_tags[HTML_TAG_KNOWN_COUNT] = {
+    [HTML_TAG_UNKNOWN] = {"", 0, 0},
+    [HTML_TAG_A] = {"a", 0, 0},
+    [HTML_TAG_ABBR] = {"abbr", 0, 0},
+    [HTML_TAG_ADDRESS] = {"address", 0, 0},
+    [HTML_TAG_AREA] = {"area", HTML_TAG_FLAG_VOID, 0},
+    [HTML_TAG_ARTICLE] = {"article", HTML_TAG_FLAG_BLOCK, 0},
+    [HTML_TAG_ASIDE] = {"aside", HTML_TAG_FLAG_BLOCK, 0},
+    [HTML_TAG_AUDIO] = {"audio", 0, 0},
+    [HTML_TAG_B] = {"b", 0, 0},
+    [HTML_TAG_BASE] = {"base", HTML_TAG_FLAG_VOID, 0},
+    [HTML_TAG_BDI] = {"bdi", 0, 0},
+    [HTML_TAG_BDO] = {"bdo", 0, 0},
+    [HTML_TAG_BLOCKQUOTE] = {"blockquote", 0, 0},
+    [HTML_TAG_BODY] = {"body", 0, 0},
+    [HTML_TAG_BR] = {"br", HTML_TAG_FLAG_VOID, 0},
+    [HTML_TAG_BUTTON] = {"button", 0, 0},
+    [HTML_TAG_CANVAS] = {"canvas", 0, 0},
+    [HTML_TAG_CAPTION] = {"caption", HTML_TAG_FLAG_TABLE_CONTENT, 0},
+    [HTML_TAG_CITE] = {"cite", 0, 0},
+    [HTML_TAG_CODE] = {"code", 0, 0},
+    [HTML_TAG_COL] = {"col", HTML_TAG_FLAG_VOID, 0},
+    [HTML_TAG_COLGROUP] = {"colgroup", 0, 0},
+    [HTML_TAG_DATA] = {"data", 0, 0},
+    [HTML_TAG_DATALIST] = {"datalist", 0, 0},
+    [HTML_TAG_DD] = {"dd", 0, 0},
+    [HTML_TAG_DEL] = {"del", 0, 0},
+    [HTML_TAG_DETAILS] = {"details", 0, 0},
+    [HTML_TAG_DFN] = {"dfn", 0, 0},
+    [HTML_TAG_DIALOG] = {"dialog", 0, 0},
+    [HTML_TAG_DIV] = {"div", HTML_TAG_FLAG_BLOCK, 0},
+    [HTML_TAG_DL] = {"dl", 0, 0},
+    [HTML_TAG_DT] = {"dt", 0, 0},
+    [HTML_TAG_EM] = {"em", 0, 0},
+    [HTML_TAG_EMBED] = {"embed", HTML_TAG_FLAG_VOID, 0},
+    [HTML_TAG_FIELDSET] = {"fieldset", HTML_TAG_FLAG_BLOCK, 0},
+    [HTML_TAG_FIGCAPTION] = {"figcaption", 0, 0},
+    [HTML_TAG_FIGURE] = {"figure", 0, 0},
+    [HTML_TAG_FOOTER] = {"footer", HTML_TAG_FLAG_BLOCK, 0},
+    [HTML_TAG_FORM] = {"form", HTML_TAG_FLAG_BLOCK, 0},
+    [HTML_TAG_H1] = {"h1", HTML_TAG_FLAG_BLOCK, 0},
+    [HTML_TAG_H2] = {"h2", HTML_TAG_FLAG_BLOCK, 0},
+    [HTML_TAG_H3] = {"h3", HTML_TAG_FLAG_BLOCK, 0},
+    [HTML_TAG_H4] = {"h4", HTML_TAG_FLAG_BLOCK, 0},
+    [HTML_TAG_H5] = {"h5", HTML_TAG_FLAG_BLOCK, 0},
+    [HTML_TAG_H6] = {"h6", HTML_TAG_FLAG_BLOCK, 0},
+    [HTML_TAG_HEAD] = {"head", 0, HTML_TAG_FLAG_HEAD_CONTENT},
+    [HTML_TAG_HEADER] = {"header", HTML_TAG_FLAG_BLOCK, 0},
+    [HTML_TAG_HR] = {"hr", HTML_TAG_FLAG_VOID, 0},
+    [HTML_TAG_HTML] = {"html", 0, 0},
+    [HTML_TAG_I] = {"i", 0, 0},
+    [HTML_TAG_IFRAME] = {"iframe", 0, 0},
+    [HTML_TAG_IMG] = {"img", HTML_TAG_FLAG_VOID, 0},
+    [HTML_TAG_INPUT] = {"input", HTML_TAG_FLAG_VOID, 0},
+    [HTML_TAG_INS] = {"ins", 0, 0},
+    [HTML_TAG_KBD] = {"kbd", 0, 0},
+    [HTML_TAG_LABEL] = {"label", 0, 0},
+    [HTML_TAG_LEGEND] = {"legend", 0, 0},
+    [HTML_TAG_LI] = {"li", HTML_TAG_FLAG_BLOCK | HTML_TAG_FLAG_LIST_CONTENT, 0},
+    [HTML_TAG_LINK] = {"link", HTML_TAG_FLAG_VOID | HTML_TAG_FLAG_HEAD_CONTENT, 0},
+    [HTML_TAG_MAIN] = {"main", HTML_TAG_FLAG_BLOCK, 0},
+    [HTML_TAG_MAP] = {"map", 0, 0},
+    [HTML_TAG_MARK] = {"mark", 0, 0},
+    [HTML_TAG_META] = {"meta", HTML_TAG_FLAG_VOID | HTML_TAG_FLAG_HEAD_CONTENT, 0},
+    [HTML_TAG_METER] = {"meter", 0, 0},
+    [HTML_TAG_NAV] = {"nav", HTML_TAG_FLAG_BLOCK, 0},
+    [HTML_TAG_NOSCRIPT] = {"noscript", 0, 0},
+    [HTML_TAG_OBJECT] = {"object", 0, 0},
+    [HTML_TAG_OL] = {"ol", HTML_TAG_FLAG_BLOCK, HTML_TAG_FLAG_LIST_CONTENT},
+    [HTML_TAG_OPTGROUP] = {"optgroup", 0, 0},
+    [HTML_TAG_OPTION] = {"option", 0, 0},
+    [HTML_TAG_OUTPUT] = {"output", 0, 0},
+    [HTML_TAG_P] = {"p", HTML_TAG_FLAG_BLOCK, 0},
+    [HTML_TAG_PARAM] = {"param", HTML_TAG_FLAG_VOID, 0},
+    [HTML_TAG_PICTURE] = {"picture", 0, 0},
+    [HTML_TAG_PRE] = {"pre", 0, 0},
+    [HTML_TAG_PROGRESS] = {"progress", 0, 0},
+    [HTML_TAG_Q] = {"q", 0, 0},
+    [HTML_TAG_RP] = {"rp", 0, 0},
+    [HTML_TAG_RT] = {"rt", 0, 0},
+    [HTML_TAG_RUBY] = {"ruby", 0, 0},
+    [HTML_TAG_S] = {"s", 0, 0},
+    [HTML_TAG_SAMP] = {"samp", 0, 0},
+    [HTML_TAG_SCRIPT] = {"script", HTML_TAG_FLAG_HEAD_CONTENT, 0},
+    [HTML_TAG_SECTION] = {"section", HTML_TAG_FLAG_BLOCK, 0},
+    [HTML_TAG_SELECT] = {"select", 0, 0},
+    [HTML_TAG_SLOT] = {"slot", 0, 0},
+    [HTML_TAG_SMALL] = {"small", 0, 0},
+    [HTML_TAG_SOURCE] = {"source", HTML_TAG_FLAG_VOID, 0},
+    [HTML_TAG_SPAN] = {"span", 0, 0},
+    [HTML_TAG_STRONG] = {"strong", 0, 0},
+    [HTML_TAG_STYLE] = {"style", HTML_TAG_FLAG_HEAD_CONTENT, 0},
+    [HTML_TAG_SUB] = {"sub", 0, 0},
+    [HTML_TAG_SUMMARY] = {"summary", 0, 0},
+    [HTML_TAG_SUP] = {"sup", 0, 0},
+    [HTML_TAG_TABLE] = {"table", HTML_TAG_FLAG_BLOCK, HTML_TAG_FLAG_TABLE_CONTENT},
+    [HTML_TAG_TBODY] = {"tbody", HTML_TAG_FLAG_TABLE_CONTENT, 0},
+    [HTML_TAG_TD] = {"td", HTML_TAG_FLAG_BLOCK | HTML_TAG_FLAG_ROW_CONTENT, 0},
+    [HTML_TAG_TEMPLATE] = {"template", 0, 0},
+    [HTML_TAG_TEXTAREA] = {"textarea", 0, 0},
+    [HTML_TAG_TFOOT] = {"tfoot", HTML_TAG_FLAG_TABLE_CONTENT, 0},
+    [HTML_TAG_TH] = {"th", HTML_TAG_FLAG_BLOCK | HTML_TAG_FLAG_ROW_CONTENT, 0},
+    [HTML_TAG_THEAD] = {"thead", HTML_TAG_FLAG_TABLE_CONTENT, 0},
+    [HTML_TAG_TIME] = {"time", 0, 0},
+    [HTML_TAG_TITLE] = {"title", HTML_TAG_FLAG_HEAD_CONTENT, 0},
+    [HTML_TAG_TR] = {"tr", HTML_TAG_FLAG_BLOCK | HTML_TAG_FLAG_TABLE_CONTENT, HTML_TAG_FLAG_ROW_CONTENT},
+    [HTML_TAG_TRACK] = {"track", HTML_TAG_FLAG_VOID, 0},
+    [HTML_TAG_U] = {"u", 0, 0},
+    [HTML_TAG_UL] = {"ul", HTML_TAG_FLAG_BLOCK, HTML_TAG_FLAG_LIST_CONTENT},
+    [HTML_TAG_VAR] = {"var", 0, 0},
+    [HTML_TAG_VIDEO] = {"video", 0, 0},
+    [HTML_TAG_WBR] = {"wbr", HTML_TAG_FLAG_VOID, 0},
+};
+
+// custom tags get ids after the known ones and live for the whole process
+static html_name_table custom_tags = {0};
+
+static int html_tag_find_known(const char *name)
+{
+    int low = HTML_TAG_UNKNOWN + 1;
+    int high = HTML_TAG_KNOWN_COUNT - 1;
+
+    while (low <= high)
+    {
+        int mid = (low + high) / 2;
+        int cmp = strcmp(name, known_tags[mid].name);
+        if (cmp == 0)
+            return mid;
+        if (cmp < 0)
+            high = mid - 1;
+        else
+            low = mid + 1;
+    }
+
+    return HTML_TAG_UNKNOWN;
+}
+
+int html_tag_lookup(const char *name)
+{
+    if (!name || !*name)
+        return HTML_TAG_UNKNOWN;
+
+    int tag = html_tag_find_known(name);
+    if (tag != HTML_TAG_UNKNOWN)
+        return tag;
+
+    int index = html_name_table_find_shared(&custom_tags, name, strlen(name));
+    return index < 0 ? HTML_TAG_UNKNOWN : HTML_TAG_KNOWN_COUNT + index;
+}
+
+int html_tag_intern(const char *name)
+{
+    if (!name || !*name)
+    {
+        html_set_error_code(HTML_ERROR_INVALID_ARGUMENT, "Tag name cannot be empty");
+        return -1;
+    }
+
+    int tag = html_tag_find_known(name);
+    if (tag != HTML_TAG_UNKNOWN)
+        return tag;
+
+    int index = html_name_table_intern_shared(&custom_tags, name, strlen(name), NULL);
+    return index < 0 ? -1 : HTML_TAG_KNOWN_COUNT + index;
+}
+
+const char *html_tag_name(int tag)
+{
+    if (tag > HTML_TAG_UNKNOWN && tag < HTML_TAG_KNOWN_COUNT)
+        return known_tags[tag].name;
+
+    return html_name_table_get_shared(&custom_tags, tag - HTML_TAG_KNOWN_COUNT);
+}
+
+static const html_tag_info *html_tag_info_of(int tag)
+{
+    if (tag > HTML_TAG_UNKNOWN && tag < HTML_TAG_KNOWN_COUNT)
+        return &known_tags[tag];
+
+    return &known_tags[HTML_TAG_UNKNOWN];
+}
+
+int html_tag_is_block(int tag)
+{
+    return (html_tag_info_of(tag)->flags & HTML_TAG_FLAG_BLOCK) != 0;
+}
+
+int html_tag_is_self_closing(int tag)
+{
+    return (html_tag_info_of(tag)->flags & HTML_TAG_FLAG_VOID) != 0;
+}
+
+int html_tag_is_valid_child(int parent_tag, int child_tag)
+{
+    unsigned char accepts = html_tag_info_of(parent_tag)->accepts;
+    return !accepts || (html_tag_info_of(child_tag)->flags & accepts) != 0;
+}
@@ -0,0 +1,364 @@
+#include "HTML.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+// a static byte run of the skeleton (slot < 0) or a placeholder to fill in
+typedef struct
+{
+    size_t offset;
+    size_t length;
+    int slot;
+    int raw;
+} html_template_op;
+
+struct html_template
+{
+    char *data;
+    size_t length;
+    html_template_op *ops;
+    int op_count;
+    int op_capacity;
+    html_name_table slots;
+};
+
+static int html_template_add_op(html_template *tpl, size_t offset, size_t length, int slot, int raw)
+{
+    if (slot < 0 && length == 0)
+        return 1;
+
+    if (tpl->op_count >= tpl->op_capacity)
+    {
+        int capacity = tpl->op_capacity ? tpl->op_capacity * 2 : 16;
+        html_template_op *ops = (html_template_op *)realloc(tpl->ops, capacity * sizeof(html_template_op));
+        if (!ops)
+        {
+            html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for template");
+            return 0;
+        }
+        tpl->ops = ops;
+        tpl->op_capacity = capacity;
+    }
+
+    html_template_op *op = &tpl->ops[tpl->op_count++];
+    op->offset = offset;
+    op->length = length;
+    op->slot = slot;
+    op->raw = raw;
+    return 1;
+}
+
+static int html_is_slot_char(char c)
+{
+    return isalnum((unsigned char)c) || c == '_' || c == '-' || c == '.';
+}
+
+// parses "{{name}}" or "{{{name}}}" at pos; returns the length of the
+// placeholder, or 0 when the braces are just text
+static size_t html_template_placeholder(const char *data, size_t pos, size_t len, size_t *name_start,
+                                        size_t *name_len, int *raw)
+{
+    size_t i = pos + 2;
+    *raw = i < len && data[i] == '{';
+    if (*raw)
+        i++;
+
+    while (i < len && data[i] == ' ')
+        i++;
+    *name_start = i;
+    while (i < len && html_is_slot_char(data[i]))
+        i++;
+    *name_len = i - *name_start;
+    while (i < len && data[i] == ' ')
+        i++;
+
+    size_t close = *raw ? 3 : 2;
+    if (*name_len == 0 || len - i < close || strncmp(data + i, "}}}", close) != 0)
+        return 0;
+
+    return i + close - pos;
+}
+
+// finds the next placeholder at or after pos; returns its offset, or len
+// when there is none
+static size_t html_template_find(const char *data, size_t len, size_t pos, size_t *size, size_t *name_start,
+                                 size_t *name_len, int *raw)
+{
+    while (pos + 1 < len)
+    {
+        const char *open = (const char *)memchr(data + pos, '{', len - pos - 1);
+        if (!open)
+            break;
+
+        pos = (size_t)(open - data);
+        if (data[pos + 1] == '{')
+        {
+            *size = html_template_placeholder(data, pos, len, name_start, name_len, raw);
+            if (*size)
+                return pos;
+        }
+        pos++;
+    }
+
+    return len;
+}
+
+// a placeholder seen in the tree, in render order; only the ones in content
+// and attribute values are slots, the ones in script or style text stay
+typedef struct
+{
+    const char *text;
+    size_t length;
+    int slot;
+} html_template_mark;
+
+typedef struct
+{
+    html_template_mark *items;
+    int count;
+    int capacity;
+} html_template_marks;
+
+static int html_template_mark_text(html_template_marks *marks, const char *text, size_t len, int slot)
+{
+    size_t size, name_start, name_len;
+    int raw;
+
+    for (size_t pos = 0; (pos = html_template_find(text, len, pos, &size, &name_start, &name_len, &raw)) < len;
+         pos += size)
+    {
+        if (marks->count >= marks->capacity)
+        {
+            int capacity = marks->capacity ? marks->capacity * 2 : 16;
+            html_template_mark *items =
+                (html_template_mark *)realloc(marks->items, capacity * sizeof(html_template_mark));
+            if (!items)
+            {
+                html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for template");
+                return 0;
+            }
+            marks->items = items;
+            marks->capacity = capacity;
+        }
+
+        html_template_mark *mark = &marks->items[marks->count++];
+        mark->text = text + pos;
+        mark->length = size;
+        mark->slot = slot;
+    }
+
+    return 1;
+}
+
+// walks the tree in the order it is rendered: attributes, then the content
+// or, without content, the children
+static int html_template_mark_tree(html_template_marks *marks, html_element *root)
+{
+    int capacity = 64;
+    int depth = 0;
+    html_element **stack = (html_element **)malloc(capacity * sizeof(html_element *));
+    if (!stack)
+    {
+        html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for template");
+        return 0;
+    }
+
+    int result = 1;
+    stack[depth++] = root;
+    while (result && depth > 0)
+    {
+        html_element *element = stack[--depth];
+
+        for (int i = 0; result && i < element->attribute_count; i++)
+        {
+            const html_attribute *attr = &element->attributes[i];
+            if (attr->value)
+                result = html_template_mark_text(marks, attr->value, attr->length, 1);
+        }
+
+        if (element->content && element->content[0])
+        {
+            // script and style text is code, where braces mean something else
+            int slot = element->tag != HTML_TAG_SCRIPT && element->tag != HTML_TAG_STYLE;
+            result = result && html_template_mark_text(marks, element->content, strlen(element->content), slot);
+            continue;
+        }
+
+        if (depth + element->children_count > capacity)
+        {
+            while (depth + element->children_count > capacity)
+                capacity *= 2;
+            html_element **grown = (html_element **)realloc(stack, capacity * sizeof(html_element *));
+            if (!grown)
+            {
+                html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for template");
+                result = 0;
+                break;
+            }
+            stack = grown;
+        }
+
+        for (int i = element->children_count - 1; i >= 0; i--)
+            stack[depth++] = element->children[i];
+    }
+
+    free(stack);
+    return result;
+}
+
+// cuts the slots out of the rendered skeleton; the output holds the marked
+// placeholders in the same order, so each one found is matched against the
+// next mark and anything else is kept as text
+static int html_template_parse(html_template *tpl, const html_template_marks *marks)
+{
+    const char *data = tpl->data;
+    size_t len = tpl->length;
+    size_t run = 0;
+    size_t size, name_start, name_len;
+    int raw;
+    int next = 0;
+
+    for (size_t pos = 0; (pos = html_template_find(data, len, pos, &size, &name_start, &name_len, &raw)) < len;
+         pos += size)
+    {
+        const html_template_mark *mark = next < marks->count ? &marks->items[next] : NULL;
+        if (!mark || mark->length != size || memcmp(mark->text, data + pos, size) != 0)
+            continue;
+
+        next++;
+        if (!mark->slot)
+            continue;
+
+        int slot = html_name_table_intern(&tpl->slots, data + name_start, name_len);
+        if (slot < 0 || !html_template_add_op(tpl, run, pos - run, -1, 0) ||
+            !html_template_add_op(tpl, 0, 0, slot, raw))
+            return 0;
+
+        run = pos + size;
+    }
+
+    return html_template_add_op(tpl, run, len - run, -1, 0);
+}
+
+html_template *html_template_compile(html_context *ctx)
+{
+    return html_template_compile_ex(ctx, NULL);
+}
+
+html_template *html_template_compile_ex(html_context *ctx, const html_render_options *options)
+{
+    html_template *tpl = (html_template *)calloc(1, sizeof(html_template));
+    if (!tpl)
+    {
+        html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for template");
+        return NULL;
+    }
+
+    // the skeleton is rendered once; placeholders pass through the renderer
+    // verbatim and are cut out of its output afterwards, guided by the ones
+    // found in the tree
+    tpl->data = html_render_to_string_ex(ctx, options);
+    if (!tpl->data)
+    {
+        free(tpl);
+        return NULL;
+    }
+
+    tpl->length = strlen(tpl->data);
+
+    html_template_marks marks = {NULL, 0, 0};
+    int parsed = html_template_mark_tree(&marks, ctx->root) && html_template_parse(tpl, &marks);
+    free(marks.items);
+    if (!parsed)
+    {
+        html_template_free(tpl);
+        return NULL;
+    }
+
+    return tpl;
+}
+
+int html_template_slot(const html_template *tpl, const char *name)
+{
+    if (!tpl || !name)
+        return -1;
+
+    return html_name_table_find(&tpl->slots, name, strlen(name));
+}
+
+int html_template_slot_count(const html_template *tpl)
+{
+    return tpl ? tpl->slots.count : 0;
+}
+
+static int html_template_write(const html_template *tpl, const char *const *values, html_writer *writer)
+{
+    for (int i = 0; i < tpl->op_count; i++)
+    {
+        const html_template_op *op = &tpl->ops[i];
+        if (op->slot < 0)
+        {
+            html_writer_append_ref(writer, tpl->data + op->offset, op->length);
+            continue;
+        }
+
+        const char *value = values ? values[op->slot] : NULL;
+        if (!value)
+            continue;
+
+        if (op->raw)
+            html_writer_append_ref(writer, value, strlen(value));
+        else
+            html_writer_append_escaped(writer, value, strlen(value));
+    }
+
+    return !writer->error;
+}
+
+int html_template_render(const html_template *tpl, const char *const *values, html_sink *sink)
+{
+    if (!tpl || !sink)
+        return 0;
+
+    html_writer writer;
+    if (!html_writer_init(&writer, HTML_WRITER_BLOCK_SIZE, html_sink_write, sink))
+        return 0;
+
+    int result = html_template_write(tpl, values, &writer);
+    result = html_writer_flush(&writer) && result;
+    html_writer_free(&writer);
+    return result;
+}
+
+char *html_template_render_to_string(const html_template *tpl, const char *const *values, size_t *length)
+{
+    if (!tpl)
+        return NULL;
+
+    // the skeleton size is a good first guess; bound values only grow it
+    html_writer writer;
+    if (!html_writer_init(&writer, tpl->length + 256, NULL, NULL))
+        return NULL;
+
+    if (!html_template_write(tpl, values, &writer) || !html_writer_putc(&writer, '\0'))
+    {
+        html_writer_free(&writer);
+        return NULL;
+    }
+
+    if (length)
+        *length = writer.length - 1;
+    return writer.data;
+}
+
+void html_template_free(html_template *tpl)
+{
+    if (!tpl)
+        return;
+
+    html_name_table_free(&tpl->slots);
+    free(tpl->ops);
+    free(tpl->data);
+    free(tpl);
+}
@@ -1,27 +1,141 @@
+// pthread_rwlock_t is only declared by <pthread.h> when POSIX 2008 is requested
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
 #include "HTML.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
 #include <ctype.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
 
 //////////////error handling functions///////////////////////
-static char error_message[500] = {0};
+#if defined(_MSC_VER)
+#define HTML_THREAD_LOCAL __declspec(thread)
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_THREADS__)
+#define HTML_THREAD_LOCAL _Thread_local
+#else
+#define HTML_THREAD_LOCAL __thread
+#endif
+
+// each thread keeps its own error; static messages and tag names are only
+// formatted when the message is asked for
+typedef struct
+{
+    int code;
+    const char *format;
+    int tags[2];
+    int formatted;
+    char message[500];
+} html_error_state;
+
+static HTML_THREAD_LOCAL html_error_state html_error = {0, NULL, {0, 0}, 1, {0}};
+
+static void html_store_error(int code, const char *format, va_list args)
+{
+    html_error.code = code;
+    html_error.format = NULL;
+    html_error.formatted = 1;
+    vsnprintf(html_error.message, sizeof(html_error.message), format, args);
+}
 
 void html_set_error(const char *format, ...)
 {
     va_list args;
     va_start(args, format);
-    vsnprintf(error_message, sizeof(error_message), format, args);
+    html_store_error(HTML_ERROR_FAILED, format, args);
     va_end(args);
 }
 
+void html_set_error_ex(int code, const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    html_store_error(code, format, args);
+    va_end(args);
+}
+
+void html_set_error_code(int code, const char *message)
+{
+    html_error.code = code;
+    html_error.format = message ? message : html_error_string(code);
+    html_error.tags[0] = 0;
+    html_error.tags[1] = 0;
+    html_error.formatted = 0;
+}
+
+void html_set_error_tags(int code, const char *format, int first, int second)
+{
+    html_error.code = code;
+    html_error.format = format;
+    html_error.tags[0] = first;
+    html_error.tags[1] = second;
+    html_error.formatted = 0;
+}
+
 const char *html_get_error()
 {
-    return error_message;
+    if (!html_error.formatted)
+    {
+        if (html_error.tags[0])
+        {
+            const char *first = html_tag_name(html_error.tags[0]);
+            const char *second = html_tag_name(html_error.tags[1]);
+            snprintf(html_error.message, sizeof(html_error.message), html_error.format, first ? first : "",
+                     second ? second : "");
+        }
+        else
+        {
+            snprintf(html_error.message, sizeof(html_error.message), "%s", html_error.format);
+        }
+        html_error.formatted = 1;
+    }
+    return html_error.message;
+}
+
+const char *html_get_last_error() { return html_get_error(); }
+
+int html_get_error_code() { return html_error.code; }
+
+const char *html_error_string(int code)
+{
+    switch (code)
+    {
+    case HTML_ERROR_NONE:
+        return "";
+    case HTML_ERROR_MEMORY:
+        return "memory allocation failed";
+    case HTML_ERROR_INVALID_ARGUMENT:
+        return "invalid argument";
+    case HTML_ERROR_INVALID_STATE:
+        return "operation not valid for the current element";
+    case HTML_ERROR_INVALID_CHILD:
+        return "invalid child tag";
+    case HTML_ERROR_DUPLICATE_ID:
+        return "duplicate element ID";
+    case HTML_ERROR_NOT_FOUND:
+        return "element not found";
+    case HTML_ERROR_IO:
+        return "output failed";
+    case HTML_ERROR_UNSUPPORTED:
+        return "not supported by this build";
+    default:
+        return "operation failed";
+    }
 }
 
-void html_clear_error() { error_message[0] = '\0'; }
+void html_clear_error()
+{
+    html_error.code = HTML_ERROR_NONE;
+    html_error.format = NULL;
+    html_error.formatted = 1;
+    html_error.message[0] = '\0';
+}
 
 //////////////string utilities functions///////////////////////
 char *html_strdup(const char *str)
@@ -30,7 +144,7 @@ char *html_strdup(const char *str)
     char *new_str = (char *)malloc(len + 1);
     if (!new_str)
     {
-        html_set_error("memory allocation failed for string duplication");
+        html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for string duplication");
         return NULL;
     }
     memcpy(new_str, str, len + 1);
@@ -51,74 +165,180 @@ char *html_strcat(char *dest, const char *src)
     return new_str;
 }
 
-char *html_escape_string(const char *str)
+static unsigned int html_name_hash(const char *name, size_t len)
 {
-    if (!str)
-        return NULL;
-    int len = strlen(str), new_len = len;
+    return (unsigned int)html_hash_bytes(name, len);
+}
+
+static int html_name_table_slot(const html_name_table *table, const char *name, size_t len)
+{
+    unsigned int mask = (unsigned int)table->slot_capacity - 1;
+    unsigned int index = html_name_hash(name, len) & mask;
 
-    for (int i = 0; i < len; i++)
+    while (table->slots[index])
     {
-        switch (str[i])
-        {
-        case '&':
-            new_len += 4;
-            break;
-        case '<':
-            new_len += 3;
-            break;
-        case '>':
-            new_len += 3;
-            break;
-        case '"':
-            new_len += 5;
-            break;
-        case '\'':
-            new_len += 4;
+        const char *candidate = table->names[table->slots[index] - 1];
+        if (strncmp(candidate, name, len) == 0 && candidate[len] == '\0')
             break;
-        }
+        index = (index + 1) & mask;
     }
 
-    if (new_len == len)
-        return html_strdup(str);
-    char *new_str = (char *)malloc(new_len + 1);
-    if (!new_str)
+    return (int)index;
+}
+
+int html_name_table_find(const html_name_table *table, const char *name, size_t len)
+{
+    if (!table || !name || table->slot_capacity == 0)
+        return -1;
+
+    int slot = html_name_table_slot(table, name, len);
+    return table->slots[slot] - 1;
+}
+
+int html_name_table_intern(html_name_table *table, const char *name, size_t len)
+{
+    if (!table || !name)
+        return -1;
+
+    int existing = html_name_table_find(table, name, len);
+    if (existing >= 0)
+        return existing;
+
+    if ((table->count + 1) * 2 > table->slot_capacity)
     {
-        html_set_error("memory allocation failed for string escaping");
-        return NULL;
+        int new_capacity = table->slot_capacity ? table->slot_capacity * 2 : 32;
+        int *new_slots = (int *)calloc(new_capacity, sizeof(int));
+        if (!new_slots)
+        {
+            html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for name table");
+            return -1;
+        }
+
+        for (int i = 0; i < table->count; i++)
+        {
+            unsigned int index = html_name_hash(table->names[i], strlen(table->names[i])) & (new_capacity - 1);
+            while (new_slots[index])
+                index = (index + 1) & (new_capacity - 1);
+            new_slots[index] = i + 1;
+        }
+
+        free(table->slots);
+        table->slots = new_slots;
+        table->slot_capacity = new_capacity;
     }
 
-    int j = 0;
-    for (int i = 0; i < len; i++)
+    if (table->count >= table->capacity)
     {
-        switch (str[i])
+        int new_capacity = table->capacity ? table->capacity * 2 : 16;
+        char **new_names = (char **)realloc(table->names, new_capacity * sizeof(char *));
+        if (!new_names)
         {
-        case '&':
-            memcpy(new_str + j, "&amp;", 5);
-            j += 5;
-            break;
-        case '<':
-            memcpy(new_str + j, "&lt;", 4);
-            j += 4;
-            break;
-        case '>':
-            memcpy(new_str + j, "&gt;", 4);
-            j += 4;
-            break;
-        case '"':
-            memcpy(new_str + j, "&quot;", 6);
-            j += 6;
-            break;
-        case '\'':
-            memcpy(new_str + j, "&#39;", 5);
-            j += 5;
-            break;
-        default:
-            new_str[j++] = str[i];
+            html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for name table");
+            return -1;
         }
+        table->names = new_names;
+        table->capacity = new_capacity;
     }
-    new_str[j] = '\0';
-    return new_str;
+
+    char *copy = (char *)malloc(len + 1);
+    if (!copy)
+    {
+        html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for name table");
+        return -1;
+    }
+    memcpy(copy, name, len);
+    copy[len] = '\0';
+
+    int slot = html_name_table_slot(table, copy, len);
+    table->names[table->count] = copy;
+    table->slots[slot] = table->count + 1;
+    return table->count++;
+}
+
+const char *html_name_table_get(const html_name_table *table, int index)
+{
+    if (!table || index < 0 || index >= table->count)
+        return NULL;
+
+    return table->names[index];
+}
+
+// the process-wide tables (attribute names, custom tags) are shared by every
+// thread: lookups take the read side, new names the write side. Interned
+// strings are never moved, so the returned pointers stay valid without the lock
+#ifdef _WIN32
+static SRWLOCK html_names_lock = SRWLOCK_INIT;
+#define html_names_read_lock() AcquireSRWLockShared(&html_names_lock)
+#define html_names_read_unlock() ReleaseSRWLockShared(&html_names_lock)
+#define html_names_write_lock() AcquireSRWLockExclusive(&html_names_lock)
+#define html_names_write_unlock() ReleaseSRWLockExclusive(&html_names_lock)
+#else
+static pthread_rwlock_t html_names_lock = PTHREAD_RWLOCK_INITIALIZER;
+#define html_names_read_lock() pthread_rwlock_rdlock(&html_names_lock)
+#define html_names_read_unlock() pthread_rwlock_unlock(&html_names_lock)
+#define html_names_write_lock() pthread_rwlock_wrlock(&html_names_lock)
+#define html_names_write_unlock() pthread_rwlock_unlock(&html_names_lock)
+#endif
+
+int html_name_table_find_shared(const html_name_table *table, const char *name, size_t len)
+{
+    html_names_read_lock();
+    int index = html_name_table_find(table, name, len);
+    html_names_read_unlock();
+    return index;
+}
+
+int html_name_table_intern_shared(html_name_table *table, const char *name, size_t len, const char **interned)
+{
+    html_names_read_lock();
+    int index = html_name_table_find(table, name, len);
+    if (index >= 0 && interned)
+        *interned = table->names[index];
+    html_names_read_unlock();
+
+    if (index >= 0)
+        return index;
+
+    html_names_write_lock();
+    index = html_name_table_intern(table, name, len);
+    if (index >= 0 && interned)
+        *interned = table->names[index];
+    html_names_write_unlock();
+    return index;
+}
+
+const char *html_name_table_get_shared(const html_name_table *table, int index)
+{
+    html_names_read_lock();
+    const char *name = html_name_table_get(table, index);
+    html_names_read_unlock();
+    return name;
+}
+
+void html_name_table_free(html_name_table *table)
+{
+    for (int i = 0; i < table->count; i++)
+        free(table->names[i]);
+    free(table->names);
+    free(table->slots);
+    memset(table, 0, sizeof(*table));
+}
+
+char *html_escape_string(const char *str)
+{
+    if (!str)
+        return NULL;
+
+    size_t len = strlen(str);
+
+    // one measuring pass sizes the copy exactly
+    html_writer writer;
+    if (!html_writer_init(&writer, html_escaped_length(str, len) + 1, NULL, NULL))
+        return NULL;
+
+    html_writer_append_escaped(&writer, str, len);
+    html_writer_putc(&writer, '\0');
+    return writer.data;
 }
 
 char *html_trim_string(char *str)
@@ -175,7 +395,8 @@ char *html_extract_attribute(const char *attributes, const char *name)
 
                         if (!value)
                         {
-                            html_set_error("memory allocation failed for attribute extraction");
+                            html_set_error_code(HTML_ERROR_MEMORY,
+                                                "memory allocation failed for attribute extraction");
                             return NULL;
                         }
 
@@ -195,7 +416,7 @@ char *html_extract_attribute(const char *attributes, const char *name)
 
                     if (!value)
                     {
-                        html_set_error("memory allocation failed for attribute extraction");
+                        html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for attribute extraction");
                         return NULL;
                     }
 
@@ -229,7 +450,7 @@ char *html_add_attribute(const char *attributes, const char *name, const char *v
     char *new_attributes = (char *)malloc(new_attr_len + 1);
     if (!new_attributes)
     {
-        html_set_error("Memory allocation failed for attribute addition");
+        html_set_error_code(HTML_ERROR_MEMORY, "Memory allocation failed for attribute addition");
         return NULL;
     }
 
@@ -258,7 +479,7 @@ html_element *html_find_head(html_context *ctx)
         return NULL;
     for (int i = 0; i < ctx->root->children_count; i++)
     {
-        if (ctx->root->children[i] && ctx->root->children[i]->tagname && strcmp(ctx->root->children[i]->tagname, "head") == 0)
+        if (ctx->root->children[i] && ctx->root->children[i]->tag == HTML_TAG_HEAD)
         {
 
             return ctx->root->children[i];
@@ -275,7 +496,7 @@ html_element *html_find_body(html_context *ctx)
     for (int i = 0; i < ctx->root->children_count; i++)
     {
 
-        if (ctx->root->children[i] && ctx->root->children[i]->tagname && strcmp(ctx->root->children[i]->tagname, "body") == 0)
+        if (ctx->root->children[i] && ctx->root->children[i]->tag == HTML_TAG_BODY)
         {
             return ctx->root->children[i];
         }
@@ -288,38 +509,8 @@ int html_is_valid_child(const char *parent_tag, const char *child_tag)
 {
     if (!parent_tag || !child_tag)
         return 0;
-    // for head
-    if (strcmp(parent_tag, "head") == 0)
-    {
-        return (strcmp(child_tag, "meta") == 0 ||
-                strcmp(child_tag, "title") == 0 ||
-                strcmp(child_tag, "link") == 0 ||
-                strcmp(child_tag, "style") == 0 ||
-                strcmp(child_tag, "script") == 0);
-    }
-    // for table
-    if (strcmp(parent_tag, "table") == 0)
-    {
-        return (strcmp(child_tag, "thead") == 0 ||
-                strcmp(child_tag, "tbody") == 0 ||
-                strcmp(child_tag, "tfoot") == 0 ||
-                strcmp(child_tag, "tr") == 0 ||
-                strcmp(child_tag, "caption") == 0);
-    }
-
-    // for table
-    if (strcmp(parent_tag, "tr") == 0)
-    {
-        return (strcmp(child_tag, "th") == 0 || strcmp(child_tag, "td") == 0);
-    }
 
-    // for list
-    if (strcmp(parent_tag, "ul") == 0 || strcmp(parent_tag, "ol") == 0)
-    {
-        return (strcmp(child_tag, "li") == 0);
-    }
-
-    return 1;
+    return html_tag_is_valid_child(html_tag_lookup(parent_tag), html_tag_lookup(child_tag));
 }
 
 char *html_generate_indent(int level)
@@ -333,7 +524,7 @@ char *html_generate_indent(int level)
     char *indent = (char *)malloc(total_spaces + 1);
     if (!indent)
     {
-        html_set_error("memory allocation failed for indentation");
+        html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for indentation");
         return NULL;
     }
 
@@ -347,19 +538,8 @@ int html_is_block_element(const char *tagname)
 {
     if (!tagname)
         return 0;
-    const char *block_elements[] = {
-        "div", "p", "h1", "h2", "h3", "h4", "h5", "h6",
-        "ul", "ol", "li", "table", "tr", "td", "th",
-        "form", "fieldset", "header", "footer",
-        "section", "article", "aside", "nav", "main", NULL};
-
-    for (int i = 0; block_elements[i]; i++)
-    {
-        if (strcmp(tagname, block_elements[i]) == 0)
-            return 1;
-    }
 
-    return 0;
+    return html_tag_is_block(html_tag_lookup(tagname));
 }
 
 int html_is_self_closing(const char *tagname)
@@ -367,18 +547,59 @@ int html_is_self_closing(const char *tagname)
     if (!tagname)
         return 0;
 
-    const char *self_closing[] = {
-        "area", "base", "br", "col", "embed", "hr", "img",
-        "input", "link", "meta", "param", "source", "track", "wbr", NULL};
+    return html_tag_is_self_closing(html_tag_lookup(tagname));
+}
+
+uint64_t html_hash_bytes(const void *data, size_t len)
+{
+    // MurmurHash64A
+    const uint64_t m = 0xc6a4a7935bd1e995ULL;
+    const int r = 47;
+    const unsigned char *bytes = (const unsigned char *)data;
+    uint64_t hash = 0x9E3779B97F4A7C15ULL ^ (len * m);
 
-    for (int i = 0; self_closing[i]; i++)
+    while (len >= 8)
     {
+        uint64_t k;
+        memcpy(&k, bytes, sizeof(k));
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+        hash ^= k;
+        hash *= m;
+        bytes += 8;
+        len -= 8;
+    }
 
-        if (strcmp(tagname, self_closing[i]) == 0)
-            return 1;
+    switch (len)
+    {
+    case 7:
+        hash ^= (uint64_t)bytes[6] << 48;
+        /* fall through */
+    case 6:
+        hash ^= (uint64_t)bytes[5] << 40;
+        /* fall through */
+    case 5:
+        hash ^= (uint64_t)bytes[4] << 32;
+        /* fall through */
+    case 4:
+        hash ^= (uint64_t)bytes[3] << 24;
+        /* fall through */
+    case 3:
+        hash ^= (uint64_t)bytes[2] << 16;
+        /* fall through */
+    case 2:
+        hash ^= (uint64_t)bytes[1] << 8;
+        /* fall through */
+    case 1:
+        hash ^= (uint64_t)bytes[0];
+        hash *= m;
     }
 
-    return 0;
+    hash ^= hash >> r;
+    hash *= m;
+    hash ^= hash >> r;
+    return hash;
 }
 
 unsigned int html_code_string(const char *str)
@@ -386,13 +607,7 @@ unsigned int html_code_string(const char *str)
     if (!str)
         return 0;
 
-    int index = 0;
-    while (*str)
-    {
-        index = +*str++;
-    }
-
-    return index;
+    return (unsigned int)html_hash_bytes(str, strlen(str));
 }
 
 int html_resize_id_map(id_map *map)
@@ -400,79 +615,15 @@ int html_resize_id_map(id_map *map)
     if (!map)
         return -1;
 
-    int new_capacity = map->capacity * 2;
-    if (new_capacity < 8)
-        new_capacity = 8;
-
-    char **new_keys = (char **)calloc(new_capacity, sizeof(char *));
-    html_element **new_values = (html_element **)calloc(new_capacity, sizeof(html_element *));
-
-    if (!new_keys || !new_values)
-    {
-        free(new_keys);
-        free(new_values);
-        html_set_error("memory allocation failed for Id map resize");
-        return -1;
-    }
-
-    for (int i = 0; i < map->capacity; i++)
-    {
-        if (map->keys[i])
-        {
-            unsigned int index = html_code_string(map->keys[i]) % new_capacity;
-            while (new_keys[index])
-            {
-                index = (index + 1) % new_capacity;
-            }
-            new_keys[index] = map->keys[i];
-            new_values[index] = map->values[i];
-        }
-    }
-
-    free(map->keys);
-    free(map->values);
-    map->keys = new_keys;
-    map->values = new_values;
-    map->capacity = new_capacity;
-    return 0;
+    return html_table_grow(map) ? 0 : -1;
 }
 
 id_map *html_create_id_map(int initial_capacity)
 {
-    if (initial_capacity < 4)
-        initial_capacity = 4;
-
-    id_map *map = (id_map *)malloc(sizeof(id_map));
-
-    if (!map)
-    {
-        html_set_error("memory allocation failed for Id map");
-        return NULL;
-    }
-
-    map->keys = (char **)calloc(initial_capacity, sizeof(char *));
-    map->values = (html_element **)calloc(initial_capacity, sizeof(html_element *));
-
-    if (!map->keys || !map->values)
-    {
-        free(map->keys);
-        free(map->values);
-        free(map);
-        html_set_error("memory allocation failed for Id map arrays");
-        return NULL;
-    }
-
-    map->capacity = initial_capacity;
-    map->size = 0;
-    return map;
+    return html_table_create(initial_capacity);
 }
 
 void html_free_id_map(id_map *map)
 {
-    if (!map)
-        return;
-
-    free(map->keys);
-    free(map->values);
-    free(map);
+    html_table_free(map);
 }
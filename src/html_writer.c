@@ -0,0 +1,315 @@
+#include "HTML.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#include <sys/uio.h>
+#include <limits.h>
+#define HTML_WRITER_VECTORED 1
+#endif
+
+// fragments at least this long are referenced in place by vectored writers
+#define HTML_WRITER_REF_MIN 128
+#define HTML_WRITER_MAX_VECTORS 256
+
+static const char html_indent_spaces[HTML_WRITER_MAX_INDENT + 1] =
+    "                                                                ";
+
+static int html_flush_file(void *target, const char *data, size_t len)
+{
+    return fwrite(data, 1, len, (FILE *)target) == len;
+}
+
+int html_write_fd(int fd, const char *data, size_t len)
+{
+    while (len > 0)
+    {
+#ifdef _WIN32
+        int written = _write(fd, data, (unsigned int)(len > 0x40000000 ? 0x40000000 : len));
+#else
+        ssize_t written = write(fd, data, len);
+#endif
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return 0;
+        }
+        // no progress with bytes left would retry forever
+        if (written == 0)
+            return 0;
+        data += written;
+        len -= (size_t)written;
+    }
+    return 1;
+}
+
+static int html_flush_fd(void *target, const char *data, size_t len)
+{
+    return html_write_fd((int)(intptr_t)target, data, len);
+}
+
+int html_writer_init(html_writer *writer, size_t capacity, html_writer_flush_fn flush, void *target)
+{
+    memset(writer, 0, sizeof(*writer));
+
+    if (capacity < 256)
+        capacity = 256;
+
+    writer->data = (char *)malloc(capacity);
+    if (!writer->data)
+    {
+        html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for output buffer");
+        writer->error = 1;
+        return 0;
+    }
+
+    writer->capacity = capacity;
+    writer->flush = flush;
+    writer->target = target;
+    return 1;
+}
+
+int html_writer_init_file(html_writer *writer, FILE *file)
+{
+    return html_writer_init(writer, HTML_WRITER_BLOCK_SIZE, html_flush_file, file);
+}
+
+int html_writer_init_fd(html_writer *writer, int fd)
+{
+    if (!html_writer_init(writer, HTML_WRITER_BLOCK_SIZE, html_flush_fd, (void *)(intptr_t)fd))
+        return 0;
+
+#ifdef HTML_WRITER_VECTORED
+    // a missing vector table only costs the zero-copy path
+    writer->vectors = malloc(HTML_WRITER_MAX_VECTORS * sizeof(struct iovec));
+#endif
+    return 1;
+}
+
+#ifdef HTML_WRITER_VECTORED
+static int html_writer_flush_vectors(html_writer *writer)
+{
+    struct iovec *vectors = (struct iovec *)writer->vectors;
+    int count = writer->vector_count;
+
+    if (writer->length > writer->segment)
+    {
+        vectors[count].iov_base = writer->data + writer->segment;
+        vectors[count].iov_len = writer->length - writer->segment;
+        count++;
+    }
+
+    int fd = (int)(intptr_t)writer->target;
+    int first = 0;
+    while (first < count)
+    {
+        if (vectors[first].iov_len == 0)
+        {
+            first++;
+            continue;
+        }
+
+        int batch = count - first;
+#ifdef IOV_MAX
+        if (batch > IOV_MAX)
+            batch = IOV_MAX;
+#endif
+
+        ssize_t written = writev(fd, vectors + first, batch);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return 0;
+        }
+        // the first vector is not empty, so no progress means the descriptor is stuck
+        if (written == 0)
+            return 0;
+
+        // skip fully written vectors and trim a partially written one
+        while (first < count && (size_t)written >= vectors[first].iov_len)
+        {
+            written -= (ssize_t)vectors[first].iov_len;
+            first++;
+        }
+        if (first < count)
+        {
+            vectors[first].iov_base = (char *)vectors[first].iov_base + written;
+            vectors[first].iov_len -= (size_t)written;
+        }
+    }
+
+    return 1;
+}
+#endif
+
+int html_writer_flush(html_writer *writer)
+{
+    if (writer->error)
+        return 0;
+
+#ifdef HTML_WRITER_VECTORED
+    if (writer->vector_count > 0)
+    {
+        int result = html_writer_flush_vectors(writer);
+        writer->vector_count = 0;
+        writer->segment = 0;
+        writer->length = 0;
+
+        if (!result)
+        {
+            html_set_error_code(HTML_ERROR_IO, "failed to write rendered output");
+            writer->error = 1;
+        }
+        return result;
+    }
+#endif
+
+    if (writer->flush && writer->length > 0)
+    {
+        if (!writer->flush(writer->target, writer->data, writer->length))
+        {
+            html_set_error_code(HTML_ERROR_IO, "failed to write rendered output");
+            writer->error = 1;
+            return 0;
+        }
+        writer->length = 0;
+    }
+
+    return 1;
+}
+
+static int html_writer_grow(html_writer *writer, size_t needed)
+{
+    size_t capacity = writer->capacity ? writer->capacity : 256;
+    while (capacity < needed)
+        capacity *= 2;
+
+    char *data = (char *)realloc(writer->data, capacity);
+    if (!data)
+    {
+        html_set_error_code(HTML_ERROR_MEMORY, "memory allocation failed for output buffer");
+        writer->error = 1;
+        return 0;
+    }
+
+    writer->data = data;
+    writer->capacity = capacity;
+    return 1;
+}
+
+int html_writer_append(html_writer *writer, const char *data, size_t len)
+{
+    if (writer->capacity - writer->length >= len)
+    {
+        memcpy(writer->data + writer->length, data, len);
+        writer->length += len;
+        return 1;
+    }
+
+    if (writer->error)
+        return 0;
+
+    if (!writer->flush)
+    {
+        if (!html_writer_grow(writer, writer->length + len))
+            return 0;
+    }
+    else
+    {
+        if (!html_writer_flush(writer))
+            return 0;
+
+        // fragments larger than the whole buffer skip the copy
+        if (len >= writer->capacity)
+        {
+            if (!writer->flush(writer->target, data, len))
+            {
+                html_set_error_code(HTML_ERROR_IO, "failed to write rendered output");
+                writer->error = 1;
+                return 0;
+            }
+            return 1;
+        }
+    }
+
+    memcpy(writer->data + writer->length, data, len);
+    writer->length += len;
+    return 1;
+}
+
+int html_writer_append_ref(html_writer *writer, const char *data, size_t len)
+{
+#ifdef HTML_WRITER_VECTORED
+    if (writer->vectors && len >= HTML_WRITER_REF_MIN && !writer->error)
+    {
+        // room for the buffered run before the reference, the reference and the final run
+        if (writer->vector_count + 3 > HTML_WRITER_MAX_VECTORS && !html_writer_flush(writer))
+            return 0;
+
+        struct iovec *vectors = (struct iovec *)writer->vectors;
+
+        if (writer->length > writer->segment)
+        {
+            vectors[writer->vector_count].iov_base = writer->data + writer->segment;
+            vectors[writer->vector_count].iov_len = writer->length - writer->segment;
+            writer->vector_count++;
+            writer->segment = writer->length;
+        }
+
+        vectors[writer->vector_count].iov_base = (void *)data;
+        vectors[writer->vector_count].iov_len = len;
+        writer->vector_count++;
+        return 1;
+    }
+#endif
+
+    return html_writer_append(writer, data, len);
+}
+
+int html_writer_puts(html_writer *writer, const char *str)
+{
+    return html_writer_append(writer, str, strlen(str));
+}
+
+int html_writer_putc(html_writer *writer, char c)
+{
+    if (writer->length < writer->capacity)
+    {
+        writer->data[writer->length++] = c;
+        return 1;
+    }
+
+    return html_writer_append(writer, &c, 1);
+}
+
+int html_writer_indent(html_writer *writer, int spaces)
+{
+    if (spaces <= 0)
+        return 1;
+
+    while (spaces > HTML_WRITER_MAX_INDENT)
+    {
+        if (!html_writer_append(writer, html_indent_spaces, HTML_WRITER_MAX_INDENT))
+            return 0;
+        spaces -= HTML_WRITER_MAX_INDENT;
+    }
+
+    return html_writer_append(writer, html_indent_spaces, (size_t)spaces);
+}
+
+void html_writer_free(html_writer *writer)
+{
+    free(writer->vectors);
+    writer->vectors = NULL;
+    writer->vector_count = 0;
+    free(writer->data);
+    writer->data = NULL;
+    writer->length = 0;
+    writer->capacity = 0;
+}
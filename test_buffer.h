@@ -0,0 +1,41 @@
+#ifndef TEST_BUFFER_H
+#define TEST_BUFFER_H
+
+#include <stdlib.h>
+#include <string.h>
+#include "HTML.h"
+
+// growable in-memory sink shared by the test programs
+
+typedef struct
+{
+    char *data;
+    size_t length;
+    size_t capacity;
+} output_buffer;
+
+static int buffer_write(void *state, const char *data, size_t len)
+{
+    output_buffer *out = (output_buffer *)state;
+    if (out->length + len + 1 > out->capacity)
+    {
+        size_t capacity = out->capacity ? out->capacity * 2 : 4096;
+        while (capacity < out->length + len + 1)
+            capacity *= 2;
+
+        char *grown = (char *)realloc(out->data, capacity);
+        if (!grown)
+            return 0;
+        out->data = grown;
+        out->capacity = capacity;
+    }
+
+    memcpy(out->data + out->length, data, len);
+    out->length += len;
+    out->data[out->length] = '\0';
+    return 1;
+}
+
+static const html_sink_ops buffer_ops = {buffer_write, NULL, NULL};
+
+#endif
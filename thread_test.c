@@ -0,0 +1,222 @@
+#define _POSIX_C_SOURCE 200809L
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "HTML.h"
+#include "test_buffer.h"
+
+// builds, queries and renders pages on several threads at once; run it
+// through `make tsan` to have ThreadSanitizer watch the shared tables
+
+#define THREADS 8
+#define PAGES_PER_THREAD 40
+
+typedef struct
+{
+    int index;
+    char *expected_string;
+    char *expected_render;
+    int failures;
+} worker;
+
+static html_context_pool *pool;
+static html_selector *shared_selector;
+static html_fragment *shared_fragment;
+
+// custom tag and attribute names shared by every thread, plus some that only
+// one thread uses, so the name tables are read and extended concurrently
+static void build_page(html_context *ctx, int index)
+{
+    char tag[32];
+    char attributes[64];
+    char content[64];
+
+    snprintf(tag, sizeof(tag), "x-thread-%d", index);
+    snprintf(attributes, sizeof(attributes), "class='card' data-thread-%d='%d'", index, index);
+
+    html_begin_tag(ctx, "x-widget", "id='widget' class='card'");
+    for (int i = 0; i < 20; i++)
+    {
+        snprintf(content, sizeof(content), "thread %d paragraph %d", index, i);
+        html_add_paragraph(ctx, i % 2 ? "class='odd'" : NULL, content);
+    }
+    html_end_tag(ctx);
+
+    html_begin_tag(ctx, tag, attributes);
+    html_begin_unordered_list(ctx, NULL);
+    for (int i = 0; i < 20; i++)
+        html_add_list_item(ctx, "item", "data-kind='row'");
+    html_end_list(ctx);
+    html_end_tag(ctx);
+
+    html_fragment_instantiate(ctx, ctx->current, shared_fragment, NULL);
+    html_fragment_instantiate(ctx, ctx->current, shared_fragment, NULL);
+}
+
+static int check(worker *w, int condition, const char *what)
+{
+    if (!condition)
+    {
+        printf("FAIL thread %d: %s\n", w->index, what);
+        w->failures++;
+    }
+    return condition;
+}
+
+static void check_queries(worker *w, html_context *ctx)
+{
+    int count = 0;
+    html_element **odd = html_query_selector_all(ctx, "x-widget.card > p.odd", &count);
+    check(w, odd && count == 10, "selector string query");
+    free(odd);
+
+    html_element **cards = html_selector_query_all(ctx, shared_selector, &count);
+    check(w, cards && count == 2, "shared compiled selector");
+    free(cards);
+
+    check(w, html_get_element_by_id(ctx, "card-2") != NULL, "fragment instance IDs");
+}
+
+// every thread provokes its own error and must read back its own message
+static void check_errors(worker *w, html_context *ctx)
+{
+    char expected[64];
+    snprintf(expected, sizeof(expected), "Unknown tag id %d", -100 - w->index);
+
+    int result = html_add_children_batch(ctx, ctx->current, -100 - w->index, NULL, 0, NULL);
+    check(w, result == -1, "invalid batch is rejected");
+    check(w, html_get_error_code() == HTML_ERROR_INVALID_ARGUMENT, "thread-local error code");
+    check(w, strcmp(html_get_error(), expected) == 0, "thread-local error message");
+}
+
+static void *run_worker(void *arg)
+{
+    worker *w = (worker *)arg;
+
+    for (int page = 0; page < PAGES_PER_THREAD && !w->failures; page++)
+    {
+        html_context *ctx = html_context_pool_acquire(pool, "Thread Test");
+        if (!check(w, ctx != NULL, "pool acquire"))
+            break;
+
+        build_page(ctx, w->index);
+        check_queries(w, ctx);
+        check_errors(w, ctx);
+
+        char *html = html_render_to_string(ctx);
+        check(w, html && strcmp(html, w->expected_string) == 0, "pooled render matches");
+        free(html);
+        html_context_pool_release(pool, ctx);
+
+        if (page % 8 != 0)
+            continue;
+
+        output_buffer out;
+        memset(&out, 0, sizeof(out));
+        html_sink *sink = html_sink_create(&buffer_ops, &out);
+        ctx = sink ? html_init_sink(sink, "Thread Test") : NULL;
+        if (check(w, ctx != NULL, "sink context"))
+        {
+            build_page(ctx, w->index);
+            html_render_parallel(ctx, 4);
+            html_finalize(ctx);
+            check(w, out.data && strcmp(out.data, w->expected_render) == 0, "parallel render matches");
+        }
+        free(out.data);
+    }
+
+    return NULL;
+}
+
+static int prepare(worker *w)
+{
+    html_context *ctx = html_init_string("Thread Test");
+    if (!ctx)
+        return 0;
+    build_page(ctx, w->index);
+    w->expected_string = html_render_to_string(ctx);
+    html_finalize(ctx);
+
+    output_buffer out;
+    memset(&out, 0, sizeof(out));
+    html_sink *sink = html_sink_create(&buffer_ops, &out);
+    ctx = sink ? html_init_sink(sink, "Thread Test") : NULL;
+    if (!ctx)
+        return 0;
+    build_page(ctx, w->index);
+    html_finalize(ctx);
+    w->expected_render = out.data;
+
+    return w->expected_string && w->expected_render;
+}
+
+int main()
+{
+    html_context *scratch = html_init_string("Fragment");
+    if (!scratch)
+        return 1;
+    html_begin_section(scratch, "id='card' class='card'");
+    html_add_paragraph(scratch, "id='card-title'", "Card");
+    html_end_section(scratch);
+    shared_fragment = html_fragment_create(html_get_element_by_id(scratch, "card"));
+    html_finalize(scratch);
+
+    shared_selector = html_selector_compile("[class~=card][id^=card]");
+    pool = html_context_pool_create(0, THREADS);
+
+    worker workers[THREADS];
+    pthread_t threads[THREADS];
+    memset(workers, 0, sizeof(workers));
+
+    int failures = 0;
+    if (!shared_fragment || !shared_selector || !pool)
+    {
+        printf("FAIL setup: %s\n", html_get_error());
+        failures++;
+    }
+
+    for (int i = 0; i < THREADS && !failures; i++)
+    {
+        workers[i].index = i;
+        if (!prepare(&workers[i]))
+        {
+            printf("FAIL setup of thread %d: %s\n", i, html_get_error());
+            failures++;
+        }
+    }
+
+    int started = 0;
+    for (; started < THREADS && !failures; started++)
+    {
+        if (pthread_create(&threads[started], NULL, run_worker, &workers[started]) != 0)
+        {
+            printf("FAIL starting thread %d\n", started);
+            failures++;
+            break;
+        }
+    }
+
+    for (int i = 0; i < started; i++)
+    {
+        pthread_join(threads[i], NULL);
+        failures += workers[i].failures;
+    }
+
+    for (int i = 0; i < THREADS; i++)
+    {
+        free(workers[i].expected_string);
+        free(workers[i].expected_render);
+    }
+    html_context_pool_free(pool);
+    html_selector_free(shared_selector);
+    html_fragment_free(shared_fragment);
+
+    if (failures)
+    {
+        printf("%d thread test failure(s)\n", failures);
+        return 1;
+    }
+    printf("ok   %d threads, %d pages each\n", THREADS, PAGES_PER_THREAD);
+    return 0;
+}